@@ -0,0 +1,573 @@
+/*!
+    @file Main.cpp @author Joel Barrett @date 16/10/26 @brief Entry point to the Maths library microbenchmarks.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "BasisTable.h"
+#include "Bezier.h"
+#include "BezierCurve.h"
+#include "Matrix.h"
+#include "Ray.h"
+
+namespace
+{
+    using namespace Framework::Maths;
+
+    typedef std::chrono::steady_clock Clock;
+
+    struct Options
+    {
+        Options(): json(NULL), baseline(NULL), filter(NULL), threshold(5.0), time(200.0){}
+
+        const char* json;
+        const char* baseline;
+        const char* filter;
+        double threshold; //!< percent
+        double time; //!< milliseconds per benchmark
+    };
+
+    //! runs the operation under test the given number of times
+    typedef std::function< void (std::size_t) > Kernel;
+
+    struct Benchmark
+    {
+        std::string name;
+        Kernel kernel;
+    };
+
+    struct Result
+    {
+        std::string name;
+        std::size_t iterations; //!< per repetition
+        double median, min; //!< nanoseconds per operation
+    };
+
+    //! timed runs of each benchmark, of which the median and fastest are reported
+    const std::size_t REPETITIONS = 5;
+
+    //! inputs are cycled through so that no operation is timed on a constant, a power of two to wrap with a mask
+    const std::size_t INPUTS = 1024;
+
+    //! a store the optimiser can't see through, so that results which are never used still have to be computed
+    volatile double sink_;
+
+    template < typename T >
+    void Sink(T value) { sink_ = static_cast<double>(value); }
+
+    void PrintUsage(const char* program)
+    {
+        std::fprintf(stderr, "usage: %s [--filter text] [--time ms] [--json file] [--baseline file] [--threshold percent]\n\n"
+            "Times each benchmark whose name contains the filter text for about ms milliseconds (200)\n"
+            "and prints nanoseconds per operation. --json writes the results to a file that a later\n"
+            "run can read with --baseline, which compares the medians and exits with failure if any\n"
+            "benchmark is slower than its baseline by more than the threshold (5%%).\n", program);
+    }
+
+    bool ParseNumber(const char* arg, double &number)
+    {
+        char* end = NULL;
+        double value = std::strtod(arg, &end);
+        if (*arg == '\0' || *end != '\0' || value < 0.0) {
+            return false;
+        }
+        number = value;
+        return true;
+    }
+
+    bool ParseOptions(int argc, char* argv[], Options &options)
+    {
+        // every option takes a value
+        for (int i = 1; i + 1 < argc; i += 2)
+        {
+            const char* option = argv[i];
+            const char* value = argv[i + 1];
+
+            if (!std::strcmp(option, "--json")) {
+                options.json = value;
+            }
+            else if (!std::strcmp(option, "--baseline")) {
+                options.baseline = value;
+            }
+            else if (!std::strcmp(option, "--filter")) {
+                options.filter = value;
+            }
+            else if (!std::strcmp(option, "--threshold")) {
+                if (!ParseNumber(value, options.threshold)) {
+                    return false;
+                }
+            }
+            else if (!std::strcmp(option, "--time")) {
+                if (!ParseNumber(value, options.time) || options.time == 0.0) {
+                    return false;
+                }
+            }
+            else {
+                return false;
+            }
+        }
+        return argc % 2 == 1;
+    }
+
+    /*!
+        Inputs shared by the benchmarks of one type, generated from a fixed seed
+        so that every run times the same work.
+    */
+    template < typename T >
+    struct Fixture
+    {
+        typedef Vector<3,T> Vec3;
+
+        Fixture()
+        {
+            unsigned int seed = 12345u;
+
+            for (std::size_t i = 0; i < INPUTS; ++i)
+            {
+                params.push_back(Random(seed));
+                points.push_back(Vec3(Random(seed, -10, 10), Random(seed, -10, 10), Random(seed, -10, 10)));
+
+                // unit directions from a camera-like origin towards the points
+                Vec3 origin(Random(seed, -1, 1), Random(seed, -1, 1), T(-20));
+                rays.push_back(Ray<3,T>(origin, Normalised(points.back() - origin)));
+            }
+
+            for (std::size_t i = 0; i < CURVES; ++i)
+            {
+                curves.push_back(BezierCurve<3,T>(points[4*i], points[4*i + 1], points[4*i + 2], points[4*i + 3]));
+            }
+
+            for (std::size_t i = 0; i < MATRICES; ++i)
+            {
+                Matrix<4,4,T> m;
+                m.Identity();
+                m.RotateX(Random(seed, 0, 360));
+                m.RotateY(Random(seed, 0, 360));
+                m[3] = Vector<4,T>(points[i][0], points[i][1], points[i][2], T(1));
+                matrices.push_back(m);
+            }
+        }
+
+        //! linear congruential generator mapped onto [lo,hi]
+        static T Random(unsigned int &seed, T lo = 0, T hi = 1)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            return lo + (hi - lo) * T(seed >> 8) / T(1 << 24);
+        }
+
+        static const std::size_t CURVES = 64, MATRICES = 64;
+
+        std::vector< T > params;
+        std::vector< Vec3 > points;
+        std::vector< Ray<3,T> > rays;
+        std::vector< BezierCurve<3,T> > curves;
+        std::vector< Matrix<4,4,T> > matrices;
+    };
+
+    /*!
+        PointAt, Compute and Split for the fixed-degree curves of Bezier.h, so that
+        each degree is instantiated and timed alongside the cubic BezierCurve.
+    */
+    template < std::size_t Degree, typename T >
+    void AddBezierBenchmarks(std::vector< Benchmark > &add, const Fixture<T> &f, const char* degree)
+    {
+        typedef Bezier<Degree,3,T> Curve;
+        const std::size_t ORDER = Curve::ORDER, CURVE_MASK = Fixture<T>::CURVES - 1;
+
+        std::shared_ptr< std::vector< Curve > > curves(new std::vector< Curve >());
+        for (std::size_t i = 0; i < Fixture<T>::CURVES; ++i) {
+            curves->push_back(Curve(&f.points[ORDER*i]));
+        }
+        std::shared_ptr< std::vector< T > > params(new std::vector< T >(f.params));
+
+        Benchmark pointAt = { std::string("Bezier<") + degree + ">::PointAt", [curves, params, CURVE_MASK](std::size_t n)
+        {
+            T sum(0);
+            for (std::size_t i = 0; i < n; ++i) {
+                sum += (*curves)[i & CURVE_MASK].PointAt((*params)[i & (INPUTS - 1)])[0];
+            }
+            Sink(sum);
+        }};
+        add.push_back(pointAt);
+
+        Benchmark compute = { std::string("Bezier<") + degree + ">::Compute", [curves, CURVE_MASK](std::size_t n)
+        {
+            T sum(0);
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                Curve &curve = (*curves)[i & CURVE_MASK];
+                curve.Compute();
+                sum += curve.GetPolylineVert(curve.GetResolution() / 2)[0];
+            }
+            Sink(sum);
+        }};
+        add.push_back(compute);
+
+        Benchmark split = { std::string("Bezier<") + degree + ">::Split", [curves, params, CURVE_MASK, ORDER](std::size_t n)
+        {
+            Vector<3,T> left[Degree + 1], right[Degree + 1];
+            T sum(0);
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                (*curves)[i & CURVE_MASK].Split((*params)[i & (INPUTS - 1)], left, right);
+                sum += left[1][0] + right[ORDER - 2][0];
+            }
+            Sink(sum);
+        }};
+        add.push_back(split);
+    }
+
+    template < typename T >
+    void AddBenchmarks(std::vector< Benchmark > &benchmarks, const char* type)
+    {
+        typedef Vector<3,T> Vec3;
+        std::shared_ptr< Fixture<T> > f(new Fixture<T>());
+        const std::size_t CURVE_MASK = Fixture<T>::CURVES - 1, MATRIX_MASK = Fixture<T>::MATRICES - 1;
+
+        std::vector< Benchmark > add;
+
+        Benchmark pointAt = { "BezierCurve::PointAt", [f, CURVE_MASK](std::size_t n)
+        {
+            T sum(0);
+            for (std::size_t i = 0; i < n; ++i) {
+                sum += f->curves[i & CURVE_MASK].PointAt(f->params[i & (INPUTS - 1)])[0];
+            }
+            Sink(sum);
+        }};
+        add.push_back(pointAt);
+
+        Benchmark tangentAt = { "BezierCurve::TangentAt", [f, CURVE_MASK](std::size_t n)
+        {
+            T sum(0);
+            for (std::size_t i = 0; i < n; ++i) {
+                sum += f->curves[i & CURVE_MASK].TangentAt(f->params[i & (INPUTS - 1)])[0];
+            }
+            Sink(sum);
+        }};
+        add.push_back(tangentAt);
+
+        // the arc-length table and bounds, which don't depend on the resolution
+        std::shared_ptr< std::vector< BezierCurve<3,T> > > coefficientCurves(new std::vector< BezierCurve<3,T> >(f->curves));
+        Benchmark coefficients = { "BezierCurve::ComputeCoefficients", [coefficientCurves, CURVE_MASK](std::size_t n)
+        {
+            T sum(0);
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                BezierCurve<3,T> &curve = (*coefficientCurves)[i & CURVE_MASK];
+                curve.ComputeCoefficients();
+                sum += curve.GetLength();
+            }
+            Sink(sum);
+        }};
+        add.push_back(coefficients);
+
+        // the track tessellates at 75 by default and at most 4096; the others bracket and fill in between
+        const std::size_t resolutions[] = { 25, 75, 300, 1000, 4096 };
+        for (std::size_t r = 0; r < sizeof(resolutions) / sizeof(resolutions[0]); ++r)
+        {
+            std::size_t res = resolutions[r];
+            std::shared_ptr< std::vector< BezierCurve<3,T> > > curves(new std::vector< BezierCurve<3,T> >(f->curves));
+            for (std::size_t i = 0; i < curves->size(); ++i) {
+                (*curves)[i].SetResolution(res);
+            }
+            std::shared_ptr< BasisTable<T> > basis(new BasisTable<T>(res));
+
+            std::stringstream name;
+            name << "/" << res;
+
+            Benchmark compute = { "BezierCurve::Compute" + name.str(), [curves, CURVE_MASK](std::size_t n)
+            {
+                T sum(0);
+                for (std::size_t i = 0; i < n; ++i)
+                {
+                    BezierCurve<3,T> &curve = (*curves)[i & CURVE_MASK];
+                    curve.Compute();
+                    sum += curve.GetLength();
+                }
+                Sink(sum);
+            }};
+            add.push_back(compute);
+
+            // forward differencing from the coefficients
+            Benchmark polyline = { "BezierCurve::ComputePolyline" + name.str(), [curves, CURVE_MASK, res](std::size_t n)
+            {
+                T sum(0);
+                for (std::size_t i = 0; i < n; ++i)
+                {
+                    BezierCurve<3,T> &curve = (*curves)[i & CURVE_MASK];
+                    curve.ComputePolyline();
+                    sum += curve.GetPolylineVert(res / 2)[0];
+                }
+                Sink(sum);
+            }};
+            add.push_back(polyline);
+
+            // the shared table of Bernstein weights the track tessellates with
+            Benchmark basisPolyline = { "BezierCurve::ComputePolyline/basis" + name.str(), [curves, basis, CURVE_MASK, res](std::size_t n)
+            {
+                T sum(0);
+                for (std::size_t i = 0; i < n; ++i)
+                {
+                    BezierCurve<3,T> &curve = (*curves)[i & CURVE_MASK];
+                    curve.ComputePolyline(*basis);
+                    sum += curve.GetPolylineVert(res / 2)[0];
+                }
+                Sink(sum);
+            }};
+            add.push_back(basisPolyline);
+        }
+
+        Benchmark split = { "BezierCurve::Split", [f, CURVE_MASK](std::size_t n)
+        {
+            Vec3 left[4], right[4];
+            T sum(0);
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                f->curves[i & CURVE_MASK].Split(f->params[i & (INPUTS - 1)], left, right);
+                sum += left[1][0] + right[2][0];
+            }
+            Sink(sum);
+        }};
+        add.push_back(split);
+
+        Benchmark deCasteljau = { "BezierCurve::deCasteljau", [f, CURVE_MASK](std::size_t n)
+        {
+            Vec3 v[6];
+            T sum(0);
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                f->curves[i & CURVE_MASK].deCasteljau(f->params[i & (INPUTS - 1)], v);
+                sum += v[5][0];
+            }
+            Sink(sum);
+        }};
+        add.push_back(deCasteljau);
+
+        AddBezierBenchmarks<2>(add, *f, "2");
+        AddBezierBenchmarks<3>(add, *f, "3");
+        AddBezierBenchmarks<5>(add, *f, "5");
+
+        Benchmark testSphere = { "Ray::TestSphere", [f](std::size_t n)
+        {
+            T sum(0);
+            for (std::size_t i = 0; i < n; ++i) {
+                sum += f->rays[i & (INPUTS - 1)].TestSphere(f->points[(i + 1) & (INPUTS - 1)], T(2));
+            }
+            Sink(sum);
+        }};
+        add.push_back(testSphere);
+
+        Benchmark dot = { "Vector::Dot", [f](std::size_t n)
+        {
+            T sum(0);
+            for (std::size_t i = 0; i < n; ++i) {
+                sum += Dot(f->points[i & (INPUTS - 1)], f->points[(i + 1) & (INPUTS - 1)]);
+            }
+            Sink(sum);
+        }};
+        add.push_back(dot);
+
+        Benchmark cross = { "Vector::Cross", [f](std::size_t n)
+        {
+            T sum(0);
+            for (std::size_t i = 0; i < n; ++i) {
+                sum += Cross(f->points[i & (INPUTS - 1)], f->points[(i + 1) & (INPUTS - 1)])[0];
+            }
+            Sink(sum);
+        }};
+        add.push_back(cross);
+
+        Benchmark normalise = { "Vector::Normalise", [f](std::size_t n)
+        {
+            T sum(0);
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                Vec3 v = f->points[i & (INPUTS - 1)];
+                sum += v.Normalise()[0];
+            }
+            Sink(sum);
+        }};
+        add.push_back(normalise);
+
+        Benchmark multiply = { "Matrix::operator*", [f, MATRIX_MASK](std::size_t n)
+        {
+            T sum(0);
+            for (std::size_t i = 0; i < n; ++i) {
+                sum += (f->matrices[i & MATRIX_MASK] * f->matrices[(i + 1) & MATRIX_MASK])[3][0];
+            }
+            Sink(sum);
+        }};
+        add.push_back(multiply);
+
+        for (std::size_t i = 0; i < add.size(); ++i)
+        {
+            add[i].name += "<";
+            add[i].name += type;
+            add[i].name += ">";
+            benchmarks.push_back(add[i]);
+        }
+    }
+
+    double Elapsed(const Kernel &kernel, std::size_t iterations)
+    {
+        Clock::time_point start = Clock::now();
+        kernel(iterations);
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    }
+
+    Result Run(const Benchmark &benchmark, const Options &options)
+    {
+        // grow the iteration count until one repetition fills its share of the time
+        double target = 1e6 * options.time / REPETITIONS;
+        std::size_t iterations = 1;
+        double elapsed = Elapsed(benchmark.kernel, iterations);
+
+        while (elapsed < target)
+        {
+            double scale = elapsed > 0.0 ? std::min(10.0, 1.2 * target / elapsed) : 10.0;
+            iterations = std::max(iterations + 1, static_cast<std::size_t>(iterations * scale));
+            elapsed = Elapsed(benchmark.kernel, iterations);
+        }
+
+        std::vector< double > times;
+        for (std::size_t i = 0; i < REPETITIONS; ++i) {
+            times.push_back(Elapsed(benchmark.kernel, iterations) / iterations);
+        }
+        std::sort(times.begin(), times.end());
+
+        Result result;
+        result.name = benchmark.name;
+        result.iterations = iterations;
+        result.median = times[REPETITIONS / 2];
+        result.min = times[0];
+        return result;
+    }
+
+    void WriteJson(const char* file, const std::vector< Result > &results)
+    {
+        std::ofstream out(file);
+        if (!out) {
+            throw std::runtime_error(std::string("Can't write ") + file);
+        }
+
+        out << "{\n    \"benchmarks\": [\n";
+        for (std::size_t i = 0; i < results.size(); ++i)
+        {
+            const Result &r = results[i];
+            out << "        { \"name\": \"" << r.name << "\", \"iterations\": " << r.iterations
+                << ", \"median_ns\": " << r.median << ", \"min_ns\": " << r.min << " }"
+                << (i + 1 < results.size() ? ",\n" : "\n");
+        }
+        out << "    ]\n}\n";
+    }
+
+    /*!
+        Medians by name from a file written by WriteJson. This is no general JSON
+        parser: it pairs each "name" with the "median_ns" that follows it, which
+        is all the format it reads ever holds.
+    */
+    std::map< std::string, double > ReadBaseline(const char* file)
+    {
+        std::ifstream in(file);
+        if (!in) {
+            throw std::runtime_error(std::string("Can't read ") + file);
+        }
+        std::stringstream ss;
+        ss << in.rdbuf();
+        std::string text = ss.str();
+
+        std::map< std::string, double > baseline;
+        const std::string NAME = "\"name\": \"", MEDIAN = "\"median_ns\": ";
+
+        for (std::size_t pos = text.find(NAME); pos != std::string::npos; pos = text.find(NAME, pos))
+        {
+            pos += NAME.size();
+            std::size_t end = text.find('"', pos);
+            std::size_t median = text.find(MEDIAN, end);
+            if (end == std::string::npos || median == std::string::npos) {
+                throw std::runtime_error(std::string("Malformed baseline ") + file);
+            }
+            baseline[text.substr(pos, end - pos)] = std::strtod(text.c_str() + median + MEDIAN.size(), NULL);
+            pos = median;
+        }
+        return baseline;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    if (!ParseOptions(argc, argv, options))
+    {
+        PrintUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    try {
+        std::map< std::string, double > baseline;
+        if (options.baseline) {
+            baseline = ReadBaseline(options.baseline);
+        }
+
+        std::vector< Benchmark > benchmarks;
+        AddBenchmarks<float>(benchmarks, "float");
+        AddBenchmarks<double>(benchmarks, "double");
+
+        std::vector< Result > results;
+        std::size_t regressions = 0;
+
+        std::printf("%-48s %12s %12s %12s%s\n", "benchmark", "median ns", "min ns", "iterations", options.baseline ? "     change" : "");
+        for (std::size_t i = 0; i < benchmarks.size(); ++i)
+        {
+            if (options.filter && !std::strstr(benchmarks[i].name.c_str(), options.filter)) {
+                continue;
+            }
+            Result r = Run(benchmarks[i], options);
+            results.push_back(r);
+
+            std::printf("%-48s %12.3f %12.3f %12u", r.name.c_str(), r.median, r.min, static_cast<unsigned>(r.iterations));
+            if (options.baseline)
+            {
+                std::map< std::string, double >::const_iterator it = baseline.find(r.name);
+                if (it == baseline.end() || it->second <= 0.0) {
+                    std::printf("        new");
+                }
+                else
+                {
+                    double change = 100.0 * (r.median - it->second) / it->second;
+                    bool regressed = change > options.threshold;
+                    std::printf("    %+6.1f%%%s", change, regressed ? "  REGRESSED" : "");
+                    regressions += regressed;
+                }
+            }
+            std::printf("\n");
+            std::fflush(stdout);
+        }
+
+        if (options.json) {
+            WriteJson(options.json, results);
+        }
+        if (regressions)
+        {
+            std::fprintf(stderr, "%u benchmark(s) slower than the baseline by more than %g%%\n", static_cast<unsigned>(regressions), options.threshold);
+            return EXIT_FAILURE;
+        }
+    }
+    catch (std::exception &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
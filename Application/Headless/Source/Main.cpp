@@ -0,0 +1,356 @@
+/*!
+    @file Main.cpp @author Joel Barrett @date 16/10/26 @brief Entry point to the headless simulation driver.
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <string>
+
+#include "Settings.h"
+#include "Track.h"
+#include "SceneRenderer.h"
+#include "MS3DModel.h"
+#include "RecordingDevice.h"
+#include "SoftwareDevice.h"
+
+namespace
+{
+    using namespace Application;
+
+    struct Options
+    {
+        Options(): settings("Assets/Settings.xml"), image(NULL), ships(1000), steps(1000), splits(0), frames(0), threads(0),
+            check(false), checkThreads(0){}
+
+        const char* settings;
+        const char* image;
+        std::size_t ships, steps, splits, frames, threads;
+        bool check;
+        std::size_t checkThreads;
+    };
+
+    void PrintUsage(const char* program)
+    {
+        std::fprintf(stderr, "usage: %s [--settings file] [--ships n] [--steps m] [--splits k] [--frames f]\n"
+            "       [--image file] [--threads t] [--check c]\n\n"
+            "Builds the track described in the settings file, defaulting to Assets/Settings.xml,\n"
+            "spreads n ships (1000) evenly around it and times m fixed steps (1000) of\n"
+            "Track::Update at the simulation rate the file gives, without a window, on t\n"
+            "threads (0 for one per hardware thread). The longest curve is split k times (0)\n"
+            "at even intervals through the steps. It then times building f frames (0) of the\n"
+            "scene on a device that only records them. Given an image file, it also renders a\n"
+            "frame at the window's size in software on t threads and writes it there as a PPM.\n"
+            "Given --check, the steps and splits are run again on one thread and on c threads\n"
+            "(0 for one per hardware thread), failing unless the ships end up the same.\n", program);
+    }
+
+    bool ParseCount(const char* arg, std::size_t &count)
+    {
+        char* end = NULL;
+        long value = std::strtol(arg, &end, 10);
+        if (*arg == '\0' || *end != '\0' || value < 0) {
+            return false;
+        }
+        count = static_cast<std::size_t>(value);
+        return true;
+    }
+
+    bool ParseOptions(int argc, char* argv[], Options &options)
+    {
+        // every option takes a value
+        for (int i = 1; i + 1 < argc; i += 2)
+        {
+            const char* option = argv[i];
+            const char* value = argv[i + 1];
+
+            if (!std::strcmp(option, "--settings")) {
+                options.settings = value;
+            }
+            else if (!std::strcmp(option, "--ships")) {
+                if (!ParseCount(value, options.ships)) {
+                    return false;
+                }
+            }
+            else if (!std::strcmp(option, "--steps")) {
+                if (!ParseCount(value, options.steps)) {
+                    return false;
+                }
+            }
+            else if (!std::strcmp(option, "--splits")) {
+                if (!ParseCount(value, options.splits)) {
+                    return false;
+                }
+            }
+            else if (!std::strcmp(option, "--frames")) {
+                if (!ParseCount(value, options.frames)) {
+                    return false;
+                }
+            }
+            else if (!std::strcmp(option, "--image")) {
+                options.image = value;
+            }
+            else if (!std::strcmp(option, "--threads")) {
+                if (!ParseCount(value, options.threads)) {
+                    return false;
+                }
+            }
+            else if (!std::strcmp(option, "--check")) {
+                if (!ParseCount(value, options.checkThreads)) {
+                    return false;
+                }
+                options.check = true;
+            }
+            else {
+                return false;
+            }
+        }
+        return argc % 2 == 1;
+    }
+
+    void Hash(unsigned int &hash, const void* data, std::size_t size)
+    {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (std::size_t i = 0; i < size; ++i) {
+            hash = (hash ^ bytes[i]) * 16777619u;
+        }
+    }
+
+    //! FNV-1a over the ships' positions, headings, curves and parameters, so runs can be checked against each other as well as timed
+    unsigned int Checksum(const Track &track)
+    {
+        unsigned int hash = 2166136261u;
+        for (std::size_t i = 0; i < track.GetNumShips(); ++i)
+        {
+            Vector3f pos = track.GetShip(i).pos, heading = track.GetShip(i).heading;
+            unsigned int curve = static_cast<unsigned int>(track.GetShip(i).currentCurve);
+            float t = track.GetShip(i).t;
+
+            Hash(hash, &pos[0], sizeof(float) * 3);
+            Hash(hash, &heading[0], sizeof(float) * 3);
+            Hash(hash, &curve, sizeof(curve));
+            Hash(hash, &t, sizeof(t));
+        }
+        return hash;
+    }
+
+    //! the settings' track with the ships spread evenly around it
+    void BuildTrack(const Settings &settings, const Options &options, Track &track)
+    {
+        settings.BuildTrack(track);
+        for (std::size_t i = 0; i < options.ships; ++i) {
+            track.AddShip(track.GetLength() * i / options.ships);
+        }
+    }
+
+    //! take the steps, splitting the longest curve between them as the options ask
+    void Simulate(const Options &options, float step, Track &track)
+    {
+        std::size_t splits = 0;
+        for (std::size_t i = 0; i < options.steps; ++i)
+        {
+            for (; splits < options.splits * (i + 1) / options.steps; ++splits) {
+                track.AddCurve();
+            }
+            track.Update(step);
+        }
+    }
+
+    /*!
+        Run the same steps and splits from the same start on one thread and on
+        threads threads, returning whether the ships end up the same. Each ship
+        is moved by one thread from state it alone writes, so however the ships
+        are shared out the results should match to the bit.
+    */
+    bool CheckThreads(const Settings &settings, const Options &options, float step, std::size_t threads)
+    {
+        Track single(1), shared(threads);
+        Track* tracks[2] = { &single, &shared };
+        unsigned int checksums[2];
+
+        for (std::size_t i = 0; i < 2; ++i)
+        {
+            BuildTrack(settings, options, *tracks[i]);
+            Simulate(options, step, *tracks[i]);
+            checksums[i] = Checksum(*tracks[i]);
+        }
+
+        std::printf("thread check:    %08x on 1 thread, %08x on %u\n", checksums[0], checksums[1],
+            static_cast<unsigned>(shared.GetNumThreads()));
+        return checksums[0] == checksums[1];
+    }
+
+    void LoadShipModel(const Settings &settings, MS3DModel &shipModel)
+    {
+        if (!shipModel.LoadModelData(settings.modelFilename_.c_str())) {
+            throw std::runtime_error("The file '" + settings.modelFilename_ + "' couldn't be found");
+        }
+    }
+
+    //! the camera the window starts with
+    Camera SettingsCamera(const Settings &settings)
+    {
+        Camera camera;
+        camera.SetView(settings.camera_.position, settings.camera_.lookAt);
+        camera.ComputeFRU();
+        return camera;
+    }
+
+    //! the ships where they are, standing still, so that the frame's two steps are the same
+    Simulation::Frame StillFrame(const Track &track)
+    {
+        Simulation::Frame frame;
+        for (std::size_t i = 0; i < track.GetNumShips(); ++i)
+        {
+            Simulation::ShipState ship = { track.GetShip(i).pos, track.GetShip(i).heading };
+            frame.current.push_back(ship);
+        }
+        frame.previous = frame.current;
+        return frame;
+    }
+
+    //! build frames of the track as the window would draw them from the settings' camera, timing and counting what they draw
+    void RecordFrames(const Settings &settings, const Track &track, std::size_t frames)
+    {
+        MS3DModel shipModel;
+        LoadShipModel(settings, shipModel);
+
+        Camera camera = SettingsCamera(settings);
+        Simulation::Frame frame = StillFrame(track);
+
+        RecordingDevice device;
+        SceneRenderer renderer;
+        shipModel.ReloadTextures(device);
+        shipModel.ReloadMeshes(device);
+        renderer.Init(device, track.GetCtrlPointRadius());
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < frames; ++i)
+        {
+            device.Reset();
+            renderer.Render(device, camera, track, frame, 1.0f, shipModel);
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        // the track's buffers are written by the first frame, and after that only when it changes
+        const RecordingDevice::Stats &last = device.GetStats();
+
+        // one more frame, hashing everything drawn, is kept out of the timing
+        RecordingDevice checked(true);
+        SceneRenderer checkedRenderer;
+        shipModel.ReloadTextures(checked);
+        shipModel.ReloadMeshes(checked);
+        checkedRenderer.Init(checked, track.GetCtrlPointRadius());
+        checkedRenderer.Render(checked, camera, track, frame, 1.0f, shipModel);
+
+        const RecordingDevice::Stats &stats = checked.GetStats();
+        std::printf("frames:          %u\n", static_cast<unsigned>(frames));
+        std::printf("per frame:       %.4f ms\n", frames ? 1000.0 * seconds / frames : 0.0);
+        std::printf("draw calls:      %u\n", static_cast<unsigned>(stats.drawCalls));
+        std::printf("vertices:        %u\n", static_cast<unsigned>(stats.vertices));
+        std::printf("state changes:   %u\n", static_cast<unsigned>(stats.stateChanges));
+        std::printf("transforms:      %u\n", static_cast<unsigned>(stats.transforms));
+        std::printf("uploads:         %u (%u bytes), then %u (%u bytes)\n",
+            static_cast<unsigned>(stats.uploads), static_cast<unsigned>(stats.uploadedBytes),
+            static_cast<unsigned>(last.uploads), static_cast<unsigned>(last.uploadedBytes));
+        std::printf("frame checksum:  %08x\n", checked.GetChecksum());
+    }
+
+    //! render a frame as the window would first show it, in software, timing it and writing it to filename
+    void RenderImage(const Settings &settings, const Track &track, const char* filename, std::size_t threads)
+    {
+        MS3DModel shipModel;
+        LoadShipModel(settings, shipModel);
+
+        Camera camera = SettingsCamera(settings);
+        Simulation::Frame frame = StillFrame(track);
+
+        int width = settings.window_.width, height = settings.window_.height;
+        SoftwareDevice device(width, height, threads);
+
+        // set up as Scene does, the light fixed in eye space
+        Light light = Light();
+        light.ambient = settings.light_.ambient;
+        light.diffuse = settings.light_.diffuse;
+        light.position = settings.light_.position;
+        device.SetLight(light);
+        device.SetProjection(45.0f, width / static_cast<float>(height), 0.1f, 500.0f);
+
+        SceneRenderer renderer;
+        shipModel.ReloadTextures(device);
+        shipModel.ReloadMeshes(device);
+        renderer.Init(device, track.GetCtrlPointRadius());
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        renderer.Render(device, camera, track, frame, 1.0f, shipModel);
+        std::chrono::steady_clock::time_point drawn = std::chrono::steady_clock::now();
+        device.Finish();
+        std::chrono::steady_clock::time_point finished = std::chrono::steady_clock::now();
+
+        if (!device.WritePPM(filename)) {
+            throw std::runtime_error(std::string("The image '") + filename + "' couldn't be written");
+        }
+
+        std::printf("image:           %dx%d on %u threads\n", width, height, static_cast<unsigned>(device.GetNumThreads()));
+        std::printf("triangles:       %u\n", static_cast<unsigned>(device.GetNumTriangles()));
+        std::printf("lines:           %u\n", static_cast<unsigned>(device.GetNumLines()));
+        std::printf("draw:            %.3f ms\n", 1000.0 * std::chrono::duration<double>(drawn - start).count());
+        std::printf("rasterise:       %.3f ms\n", 1000.0 * std::chrono::duration<double>(finished - drawn).count());
+        std::printf("image checksum:  %08x\n", device.GetChecksum());
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    if (!ParseOptions(argc, argv, options))
+    {
+        PrintUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    try {
+        Settings settings;
+        settings.Load(options.settings);
+
+        Track track(options.threads);
+        BuildTrack(settings, options, track);
+
+        // the same fixed step the simulation thread takes
+        float step = 1.0f / settings.simulation_.rate;
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        Simulate(options, step, track);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        double shipSteps = static_cast<double>(options.ships) * options.steps;
+        std::printf("curves:          %u\n", static_cast<unsigned>(track.GetNumCurves()));
+        std::printf("ships:           %u\n", static_cast<unsigned>(options.ships));
+        std::printf("steps:           %u of %g s\n", static_cast<unsigned>(options.steps), step);
+        std::printf("threads:         %u\n", static_cast<unsigned>(track.GetNumThreads()));
+        std::printf("time:            %.3f s\n", seconds);
+        std::printf("per step:        %.4f ms\n", options.steps ? 1000.0 * seconds / options.steps : 0.0);
+        std::printf("ship-steps/s:    %.0f\n", seconds > 0.0 ? shipSteps / seconds : 0.0);
+        std::printf("checksum:        %08x\n", Checksum(track));
+
+        if (options.frames) {
+            RecordFrames(settings, track, options.frames);
+        }
+        if (options.image) {
+            RenderImage(settings, track, options.image, options.threads);
+        }
+        if (options.check && !CheckThreads(settings, options, step, options.checkThreads))
+        {
+            std::fprintf(stderr, "The ships ended up differently on different numbers of threads\n");
+            return EXIT_FAILURE;
+        }
+    }
+    catch (std::exception &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,133 @@
+/*!
+    @file BVH.h @author Joel Barrett @date 16/10/26 @brief A bounding volume hierarchy over track curves.
+*/
+
+#ifndef APPLICATION_BVH_H
+#define APPLICATION_BVH_H
+
+#if _MSC_VER > 1000
+    #pragma once
+#endif
+
+#include <limits>
+#include <vector>
+
+#include "AABB.h"
+#include "BezierCurve.h"
+#include "Ray.h"
+
+namespace Application
+{
+    using namespace Framework::Maths;
+
+    /*!
+        A binary tree of boxes with one curve per leaf, built top-down by splitting 
+        the curves at the median of their box centres along the widest axis. Leaves 
+        bound the curve and its control point spheres, so the tree serves picking as 
+        well as queries against the curve itself. Moving a curve only refits the 
+        boxes on the path from its leaf to the root, and a curve split in two is 
+        inserted beside the other half rather than rebuilding the tree.
+    */
+    class BVH
+    {
+    public:
+        //! build the tree over all curves, padding the control points by ctrlPointRadius
+        void Build(const std::vector< BezierCurve<> > &curves, float ctrlPointRadius);
+
+        //! refit the boxes above curve i after it has changed shape
+        void Refit(const std::vector< BezierCurve<> > &curves, std::size_t i);
+
+        //! add curve i, split off from curve sibling, by pairing it with the sibling's leaf
+        void Insert(const std::vector< BezierCurve<> > &curves, std::size_t i, std::size_t sibling);
+
+        //! curves whose leaf boxes are hit by a ray, in ascending order
+        void IntersectRay(const Ray<3> &ray, std::vector<std::size_t> &curves) const;
+
+        //! curves whose leaf boxes overlap a box, in ascending order
+        void IntersectAABB(const AABB<3> &box, std::vector<std::size_t> &curves) const;
+
+        /*!
+            Find the curve nearest p, where dist(i) returns the distance from p to curve i. 
+            Subtrees whose boxes lie further away than the best distance so far are skipped.
+        */
+        template < typename Dist >
+        std::size_t Nearest(const Vector3f &p, Dist dist, float &best) const;
+
+    private:
+        struct Node
+        {
+            AABB<3> bounds;
+            int parent, left, right; //!< left is -1 for leaves
+            std::size_t curve;
+        };
+
+        //! build the subtree over order_[first,last) and return its node index
+        int BuildRange(std::size_t first, std::size_t last, int parent);
+
+        AABB<3> LeafBounds(const BezierCurve<> &curve) const;
+
+    private:
+        std::vector<Node> nodes_;
+
+        std::vector<std::size_t> order_; //!< curve indices, partitioned during the build
+        std::vector< AABB<3> > leafBounds_; //!< indexed by curve during the build
+        std::vector<int> leaves_; //!< leaf node of each curve
+
+        float ctrlPointRadius_;
+
+        //! deeper than any median-split tree over a realistic number of curves
+        static const std::size_t MAX_DEPTH = 64;
+
+        //! insertions deepen the tree, so it is rebuilt once a leaf sinks below this
+        static const std::size_t MAX_INSERT_DEPTH = 32;
+    };
+
+    template < typename Dist >
+    std::size_t BVH::Nearest(const Vector3f &p, Dist dist, float &best) const
+    {
+        std::size_t nearest = 0;
+        best = std::numeric_limits<float>::max();
+
+        if (nodes_.empty()) {
+            return nearest;
+        }
+
+        int stack[MAX_DEPTH];
+        std::size_t top = 0;
+        stack[top++] = 0;
+
+        while (top)
+        {
+            const Node &node = nodes_[stack[--top]];
+            if (node.bounds.DistSqr(p) >= Sqr(best)) {
+                continue;
+            }
+
+            if (node.left < 0)
+            {
+                float d = dist(node.curve);
+                if (d < best)
+                {
+                    best = d;
+                    nearest = node.curve;
+                }
+                continue;
+            }
+
+            // push the further child first so that the nearer is searched first
+            if (nodes_[node.left].bounds.DistSqr(p) < nodes_[node.right].bounds.DistSqr(p))
+            {
+                stack[top++] = node.right;
+                stack[top++] = node.left;
+            }
+            else
+            {
+                stack[top++] = node.left;
+                stack[top++] = node.right;
+            }
+        }
+        return nearest;
+    }
+}
+
+#endif // APPLICATION_BVH_H
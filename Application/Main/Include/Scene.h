@@ -9,10 +9,15 @@
     #pragma once
 #endif
 
+#include "OpenGLApp.h"
+#include "GLRenderDevice.h"
+#include "Camera.h"
 #include "Track.h"
+#include "Simulation.h"
 #include "Light.h"
 #include "Colour.h"
 #include "MS3DModel.h"
+#include "SceneRenderer.h"
 #include "Settings.h"
 #include "Resource.h"
 
@@ -20,6 +25,7 @@ namespace Application
 {
     using namespace Framework::Maths;
     using namespace Framework::OpenGL;
+    using namespace Framework::Rendering;
 
     /*!
         Class for initialising and arranging the scene.
@@ -32,35 +38,41 @@ namespace Application
         //! loads settings from xml file and initialises each aspect of the scene
         void Init();
 
-        //! enters the windows message loop - our "game loop"
+        //! enters the windows message loop - our "game loop" - rendering as the simulation steps on its own thread
         void Execute();
 
     private:
         void InitWindow();
         void InitEntities();
         void InitOpenGL();
-        void InitDisplayLists();
 
-        //! updates the state of any entities within the scene
-        void Update(float dt);
+        //! follows the first ship with the camera, alpha of the way between the frame's steps
+        void Update(const Simulation::Frame &frame, float alpha);
 
-        void Render();
-        void RenderTrack();
-        void RenderCPLines();
-        void RenderCPSpheres();
-        void RenderShips();
+        void Render(const Simulation::Frame &frame, float alpha);
+
+        //! cast a ray through the mouse into the track, if it's over a control point
+        void SelectCtrlPoint(int x, int y);
+
+        //! unproject the mouse at the depth the control point was picked at and move it there
+        void DragCtrlPoint(int x, int y);
 
         //! overriden message router for this application
         LRESULT CALLBACK MsgRouter(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
 
     private:
-        GLuint gridDisplayList_, sphereDisplayList_;
+        GLRenderDevice device_;
+        SceneRenderer renderer_;
 
         Settings settings_;
         MS3DModel shipModel_;
         Camera camera_;
         Track track_;
+        Simulation simulation_; //!< holds track_ until destroyed, so must follow it
         Light light_;
+
+        float zDistToPixel_; //!< depth of the picked control point, range [0:1]
+        Vector4i viewport_;
     };
 }
 
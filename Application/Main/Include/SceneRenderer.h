@@ -0,0 +1,91 @@
+/*!
+    @file SceneRenderer.h @author Joel Barrett @date 16/10/26 @brief Builds frames of the scene on a render device.
+*/
+
+#ifndef APPLICATION_SCENERENDERER_H
+#define APPLICATION_SCENERENDERER_H
+
+#if _MSC_VER > 1000
+    #pragma once
+#endif
+
+#include <vector>
+
+#include "RenderDevice.h"
+#include "Simd.h"
+#include "Camera.h"
+#include "Model.h"
+#include "Track.h"
+#include "Simulation.h"
+
+namespace Application
+{
+    using namespace Framework::Maths;
+    using namespace Framework::OpenGL;
+    using namespace Framework::Rendering;
+
+    /*!
+        Draws the grid, the track, its control polygon and points and the ships
+        through a render device, so that the frame the window shows can also be
+        built without one.
+    */
+    class SceneRenderer
+    {
+    public:
+        SceneRenderer();
+
+        //! create the meshes every frame draws, the track's buffers being made as it's first drawn
+        void Init(RenderDevice &device, float ctrlPointRadius);
+        void Release(RenderDevice &device);
+
+        //! a frame seen from camera, with the ships alpha of the way between the frame's steps
+        void Render(RenderDevice &device, const Camera &camera, const Track &track,
+            const Simulation::Frame &frame, float alpha, Model &shipModel);
+
+    private:
+        //! bring the track's buffers up to date, writing only the curves that changed since the last frame
+        void UpdateTrackBuffers(RenderDevice &device, const Track &track);
+
+        //! the track's pool in track order and closed back onto the first curve
+        void UpdateTrackIndices(RenderDevice &device, const Track &track);
+
+        //! make sure buffer holds at least count elements, recreating it empty if not
+        static void ReserveBuffer(RenderDevice &device, RenderDevice::Buffer &buffer, std::size_t &capacity,
+            std::size_t count, bool indices);
+
+        void RenderTrack(RenderDevice &device);
+        void RenderCPLines(RenderDevice &device, const Track &track);
+        void RenderCPSpheres(RenderDevice &device, const Track &track);
+        void RenderShips(RenderDevice &device, const Camera &camera,
+            const Simulation::Frame &frame, float alpha, Model &shipModel);
+
+        //! every ship's model matrix, alpha of the way between the frame's steps, into instances_
+        void BuildInstances(const Simulation::Frame &frame, float alpha);
+        void BuildInstancesScalar(const Simulation::Frame &frame, float alpha, std::size_t first, std::size_t last);
+#ifdef MATHS_SIMD_X86
+        //! four ships from first on, which must all have been in the step before
+        void BuildInstancesSSE(const Simulation::Frame &frame, float alpha, std::size_t first);
+#endif
+
+    private:
+        RenderDevice::Mesh gridMesh_, sphereMesh_;
+
+        //! the track's vertex pool, the indices that draw it as one strip and the control polygon, kept
+        //! on the device between frames
+        RenderDevice::Buffer trackVertices_, trackIndices_, ctrlPoints_;
+        std::size_t trackVertexCapacity_, trackIndexCapacity_, ctrlPointCapacity_;
+        std::size_t numTrackIndices_;
+
+        //! the track as it was when the buffers were last written
+        unsigned int layoutVersion_;
+        std::vector< unsigned int > curveVersions_;
+        std::vector< std::size_t > curveOffsets_, curveCounts_;
+
+        //! scratch space for the writes, kept to save allocating every frame
+        std::vector< Vector3f > lineVerts_;
+        std::vector< unsigned int > indices_;
+        std::vector< RenderDevice::Instance > instances_;
+    };
+}
+
+#endif // APPLICATION_SCENERENDERER_H
@@ -20,6 +20,8 @@ namespace Application
 {
     using namespace Framework::Maths;
 
+    class Track;
+
     struct CurveSettings
     {
         std::vector< Vector3f > ctrlPoints;
@@ -42,16 +44,25 @@ namespace Application
         Vector3f position, lookAt;
     };
 
+    struct SimulationSettings
+    {
+        float rate; //!< steps per second
+    };
+
     class Settings
     {
     public:
         void Load(const char* pFilename);
 
+        //! generate the track based on the curves described in the file
+        void BuildTrack(Track &track) const;
+
     public:
         std::string name_;
         WindowSettings window_;
         std::string modelFilename_;
         CameraSettings camera_;
+        SimulationSettings simulation_;
         std::vector< CurveSettings > track_;
         LightSettings light_;
     };
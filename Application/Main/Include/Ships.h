@@ -0,0 +1,80 @@
+/*!
+    @file Ships.h @author Joel Barrett @date 16/10/26 @brief Structure-of-arrays storage for the ships on a track.
+*/
+
+#ifndef APPLICATION_SHIPS_H
+#define APPLICATION_SHIPS_H
+
+#if _MSC_VER > 1000
+    #pragma once
+#endif
+
+#include <cassert>
+#include <vector>
+
+#include "Simd.h"
+#include "Vector.h"
+
+namespace Application
+{
+    using namespace Framework::Maths;
+
+    /*!
+        The state of every ship on the track, held as one array per field so
+        that the per-frame kernels stream through exactly the fields they use.
+        Moving a ship along its curve is left to the track; the kernels then
+        evaluate each ship's position and heading from its curve's polynomial
+        and trade potential energy for speed, four ships at a time with SSE.
+        The vectorised and scalar paths perform the same float operations as
+        BezierCurve::PointAt and TangentAt, so results do not depend on the path.
+    */
+    class Ships
+    {
+    public:
+        //! floats per curve in the table given to Evaluate: a, b, c and d of PointAt's polynomial
+        static const std::size_t POLYNOMIAL_SIZE = 12;
+
+    public:
+        std::size_t size() const { return t_.size(); }
+        bool empty() const { return t_.empty(); }
+
+        void push_back(const Vector3f &pos, const Vector3f &heading, std::size_t curve, float t);
+        void pop_back();
+
+        // accessor methods
+        float GetT(std::size_t i) const { assert(i < size()); return t_[i]; }
+        float GetSpeed(std::size_t i) const { assert(i < size()); return speed_[i]; }
+        std::size_t GetCurve(std::size_t i) const { assert(i < size()); return curve_[i]; }
+        Vector3f GetPosition(std::size_t i) const { assert(i < size()); return Vector3f(pos_[0][i], pos_[1][i], pos_[2][i]); }
+        Vector3f GetHeading(std::size_t i) const { assert(i < size()); return Vector3f(heading_[0][i], heading_[1][i], heading_[2][i]); }
+
+        void SetT(std::size_t i, float t) { assert(i < size()); t_[i] = t; }
+        void SetCurve(std::size_t i, std::size_t curve) { assert(i < size()); curve_[i] = curve; }
+
+        //! energy per unit mass, 1/2 v^2 + g h, of ships [first, last) before they move
+        void ComputeEnergy(float gravity, std::size_t first, std::size_t last);
+
+        /*!
+            Place ships [first, last) at parameter t of their curves, whose polynomials 
+            start at polynomials[POLYNOMIAL_SIZE * curve], and set their speeds by 
+            conservation of the energy last computed, to no less than 2. Each ship 
+            is written alone, so ranges can be evaluated on different threads.
+        */
+        void Evaluate(const float* polynomials, float gravity, std::size_t first, std::size_t last);
+
+    private:
+        void ComputeEnergyScalar(std::size_t first, std::size_t last, float gravity);
+        void EvaluateScalar(std::size_t first, std::size_t last, const float* polynomials, float gravity);
+#ifdef MATHS_SIMD_X86
+        void ComputeEnergySSE(std::size_t first, float gravity);
+        void EvaluateSSE(std::size_t first, const float* polynomials, float gravity);
+#endif
+
+    private:
+        std::vector<float> t_, speed_, energy_;
+        std::vector<float> pos_[3], heading_[3]; //!< indexed by [axis][ship]
+        std::vector<std::size_t> curve_;
+    };
+}
+
+#endif // APPLICATION_SHIPS_H
@@ -0,0 +1,97 @@
+/*!
+    @file Simulation.h @author Joel Barrett @date 16/10/26 @brief Fixed-timestep simulation of a track on its own thread.
+*/
+
+#ifndef APPLICATION_SIMULATION_H
+#define APPLICATION_SIMULATION_H
+
+#if _MSC_VER > 1000
+    #pragma once
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Track.h"
+#include "TripleBuffer.h"
+
+namespace Application
+{
+    using namespace Framework::Maths;
+    using namespace Framework::Utilities;
+
+    /*!
+        Steps a track's ships at a fixed rate on a thread of its own, so that the
+        speed of the simulation no longer depends on the frame rate and a slow
+        frame doesn't hold it up. After every step the ships are published to
+        the renderer through a triple buffer, together with their state at the
+        step before, so that frames falling between steps can be interpolated.
+
+        The simulation thread only writes the ships. Anything else that changes
+        the track, such as editing the curves or adding ships, must hold Lock()
+        while it does; reading the curves from the thread that edits them needs
+        no lock.
+    */
+    class Simulation
+    {
+    public:
+        typedef std::chrono::steady_clock Clock;
+
+        struct ShipState
+        {
+            Vector3f pos, heading;
+        };
+
+        //! the ships after one step and the step before
+        struct Frame
+        {
+            std::vector< ShipState > previous, current;
+            Clock::time_point time; //!< when current was computed
+
+            //! ship i a fraction alpha of the way from the previous step to the current one
+            ShipState Interpolate(std::size_t i, float alpha) const;
+        };
+
+    public:
+        Simulation();
+        ~Simulation();
+
+        //! step track rate times a second until stopped
+        void Start(Track &track, float rate);
+        void Stop();
+
+        //! exclusive access to the track between steps
+        std::unique_lock<std::mutex> Lock() { return std::unique_lock<std::mutex>(mutex_); }
+
+        //! the latest frame, and how far the present lies between its steps in alpha
+        const Frame& AcquireFrame(float &alpha);
+
+    private:
+        Simulation(const Simulation &);
+        Simulation& operator = (const Simulation &);
+
+        void Run();
+        void Publish();
+
+    private:
+        Track* track_;
+
+        std::thread thread_;
+        std::atomic<bool> running_;
+        std::mutex mutex_;
+
+        float step_; //!< seconds
+        TripleBuffer< Frame > frames_;
+
+        //! the ships as last published, owned by the simulation thread
+        std::vector< ShipState > last_;
+
+        //! steps to catch up on at most after a stall, beyond which time is dropped
+        static const int MAX_CATCH_UP = 5;
+    };
+}
+
+#endif // APPLICATION_SIMULATION_H
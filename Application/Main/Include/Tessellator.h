@@ -0,0 +1,57 @@
+/*!
+    @file Tessellator.h @author Joel Barrett @date 16/10/26 @brief Batched tessellation of track curves.
+*/
+
+#ifndef APPLICATION_TESSELLATOR_H
+#define APPLICATION_TESSELLATOR_H
+
+#if _MSC_VER > 1000
+    #pragma once
+#endif
+
+#include <vector>
+
+#include "BezierCurve.h"
+#include "ThreadPool.h"
+
+namespace Application
+{
+    using namespace Framework::Maths;
+    using namespace Framework::Utilities;
+
+    /*!
+        Generates the uniform polylines of many cubic curves of equal resolution 
+        in one pass. Each polyline is the product of the shared basis table for 
+        that resolution and the curve's control points. Control points are 
+        gathered into structure-of-arrays form so that each SIMD lane evaluates a 
+        different curve, four curves at a time with SSE or eight with AVX, over 
+        blocks of four samples, and lane groups are shared between the threads of 
+        a pool. Output is identical to BezierCurve::ComputePolyline with the same table.
+    */
+    class Tessellator
+    {
+    public:
+        //! write res polyline vertices into each curve
+        void Tessellate(std::vector< BezierCurve<> > &curves, std::size_t res, ThreadPool &pool);
+
+    private:
+        //! copy control points into soa_ and size each curve's polyline storage
+        void Gather(std::vector< BezierCurve<> > &curves, std::size_t res);
+
+        // tessellate the curves from first up to the width of a lane group
+        void TessellateScalar(std::size_t first, std::size_t last, const BasisTable<float> &basis);
+        void TessellateSSE(std::size_t first, const BasisTable<float> &basis);
+        void TessellateAVX(std::size_t first, const BasisTable<float> &basis);
+
+    private:
+        //! control point components indexed by [point][axis][curve], padded to a whole lane group
+        std::vector<float> soa_[4][3];
+
+        //! first float of each curve's polyline storage
+        std::vector<float*> out_;
+
+        BasisCache<float> basis_;
+    };
+}
+
+#endif // APPLICATION_TESSELLATOR_H
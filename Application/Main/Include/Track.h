@@ -9,81 +9,228 @@
     #pragma once
 #endif
 
+#include <limits>
 #include <vector>
 
 #include "BezierCurve.h"
-#include "OpenGLApp.h"
-#include "Camera.h"
+#include "BVH.h"
+#include "IndexedHeap.h"
+#include "PrefixSumTree.h"
+#include "Ships.h"
+#include "Tessellator.h"
+#include "ThreadPool.h"
 #include "Ray.h"
 
 namespace Application
 {
     using namespace Framework::Maths;
-    using namespace Framework::Rendering;
+    using namespace Framework::Utilities;
 
     /*!
-        A piecewise bezier curve track.
+        A piecewise bezier curve track. Curves are identified by the index of the 
+        slot they were created in, which never changes, and are linked into the 
+        circuit by next and previous indices, so splitting a curve only appends 
+        to the slots and relinks its neighbours.
     */
     class Track
     {
+        //! a copy of one ship's state, which is held in ships_
         struct Ship
         {
-            Ship(const Point3f &p, const Vector3f &h)
-                : t(0.0f), speed(2.0f), up(Vector3f::UNIT_Y), pos(p), heading(h), currentCurve(0){}
+            Ship(const Ships &ships, std::size_t i)
+                : t(ships.GetT(i)), speed(ships.GetSpeed(i)), up(Vector3f::UNIT_Y), pos(ships.GetPosition(i)), 
+                  heading(ships.GetHeading(i)), currentCurve(ships.GetCurve(i)){}
 
             float t, speed;
-            Vector3f up, pos, oldpos, heading, oldhead;
-            unsigned int currentCurve;
+            Vector3f up, pos, heading;
+            std::size_t currentCurve;
         };
 
     public:
-        Track();
+        //! the point on the track nearest a query point
+        struct Projection
+        {
+            Projection(): curve(0), t(0.0f), dist(0.0f){}
+
+            std::size_t curve;
+            float t, dist;
+        };
+
+        //! a point on the track as a curve and a parameter along it
+        struct Location
+        {
+            Location(): curve(0), t(0.0f){}
+
+            std::size_t curve;
+            float t;
+        };
+
+    public:
+        //! threads share the ship updates and tessellation, 0 meaning one per hardware thread
+        explicit Track(std::size_t threads = 0);
 
         void AddFirstCurve(const Vector3f &a, const Vector3f &b, const Vector3f &c, const Vector3f &d);
         void AddCurveToEnd(const Vector3f &c, const Vector3f &d);
         void AddLastCurve();
         void AddCurve(); //! add curve to circuit by splitting longest curve
 
-        void AddShip();
+        //! generate the polylines of all curves in one batch, building the BVH the first time
+        void Tessellate();
+
+        //! project a point onto the track
+        Projection ClosestPoint(const Vector3f &p) const;
+
+        //! project count points onto the track, sharing the queries between threads
+        void ClosestPoints(const Vector3f* points, std::size_t count, Projection* results);
+
+        //! the point distance along the track from the start of the first curve, wrapping round laps
+        Location Locate(float distance) const;
+
+        //! distance along the track from the start of the first curve to parameter t of curve
+        float DistanceAt(std::size_t curve, float t) const;
+
+        //! add a ship distance along the track
+        void AddShip(float distance = 0.0f);
         void RemoveShip();
         void Update(float dt);
 
         // accessor methods
         const BezierCurve<> & GetCurve(std::size_t i) const { assert(i < curves_.size()); return curves_[i]; }
-        const Ship & GetShip(std::size_t i) const { assert(i < ships_.size()); return ships_[i]; }
+        std::size_t GetFirstCurve() const { return first_; }
+        std::size_t GetNextCurve(std::size_t i) const { assert(i < curves_.size()); return next_[i]; }
+        std::size_t GetPrevCurve(std::size_t i) const { assert(i < curves_.size()); return prev_[i]; }
+        Ship GetShip(std::size_t i) const { assert(i < ships_.size()); return Ship(ships_, i); }
+        const Ships & GetShips() const { return ships_; }
         const float GetCtrlPointRadius() const { return ctrlPointRadius_; }
         std::size_t GetNumCurves() const { return curves_.size(); }
         std::size_t GetNumShips() const { return ships_.size(); }
-        std::size_t GetResolution() const { return curves_.front().GetResolution(); }
-        float GetLength() const { return length_; }
+        std::size_t GetResolution() const { return curves_[first_].GetResolution(); }
+        float GetLength() const { return distances_.total(); }
+        std::size_t GetNumThreads() const { return threadPool_.GetNumThreads(); }
+
+        // the polylines of all curves in one buffer, with a range per curve
+        const Vector3f* GetVertices() const { return vertices_.empty() ? NULL : &vertices_[0]; }
+        std::size_t GetNumVertices() const { return vertices_.size(); }
+        std::size_t GetVertexOffset(std::size_t i) const { assert(i < curves_.size()); return ranges_[i].offset; }
+        std::size_t GetVertexCount(std::size_t i) const { assert(i < curves_.size()); return curves_[i].GetNumPolylineVerts(); }
+
+        //! bumped when curve i's control points and polyline change, in place or in a new range at the end of the buffer
+        unsigned int GetCurveVersion(std::size_t i) const { assert(i < curves_.size()); return curveVersions_[i]; }
+
+        //! bumped when the ranges are all laid out again, so that the whole buffer has to be read again
+        unsigned int GetLayoutVersion() const { return layoutVersion_; }
 
+        //! refine or coarsen the polylines: resolution when uniform, chord tolerance when adaptive
         void IncResolution();
         void DecResolution();
+        void ToggleTessellationMode();
+        BezierCurve<>::TessellationMode GetTessellationMode() const { return tessellationMode_; }
+        float GetChordTolerance() const { return chordTolerance_; }
         void SetCtrlPointSelected(bool isSelected) { ctrlPointSelected_ = isSelected; }
         bool IsCtrlPointSelected() const { return ctrlPointSelected_; }
 
-        // allow the user to pick and move a CP with the mouse
-        void SelectCtrlPoint(const Camera &cam, unsigned width, unsigned height, int x, int y);
-        void DragCtrlPoint(int x, int y);
+        // allow the user to pick and move a CP with the mouse, leaving the mapping from screen to world space to the caller
+        void SelectCtrlPoint(Ray<3> ray);
+        void DragCtrlPoint(const Vector3d &move);
+
+    private:
+        //! where a curve's polyline lives in vertices_
+        struct Range
+        {
+            Range(std::size_t offset = 0, std::size_t capacity = 0): offset(offset), capacity(capacity){}
+
+            std::size_t offset, capacity;
+        };
+
+        //! append a curve to the slots and link it into the circuit before curve next, as the new first curve if first
+        std::size_t LinkCurve(BezierCurve<> &curve, std::size_t next, bool first = false);
+
+        //! move ship i from one curve's list of ships to another's, or off the track if to is past the end
+        void MoveShip(std::size_t i, std::size_t from, std::size_t to);
+
+        //! copy curve i's polynomial into polynomials_ for the ship kernels
+        void StorePolynomial(std::size_t i);
+
+        //! add curve i, just appended, to the BVH once it has been built
+        void InsertIntoBVH(std::size_t i);
+
+        //! give a new curve the track's tessellation settings
+        void ApplyTessellationMode(BezierCurve<> &curve) const;
+
+        //! bring curve i's coefficients, polyline and bounds up to date after its control points move
+        void Recompute(std::size_t i);
+
+        //! point every curve's polyline at its range of vertices_
+        void AttachRanges();
+
+        //! lay out vertices_ in track order with a range of count vertices per curve for them to be written into
+        void ReserveRanges(std::size_t count);
+
+        //! rebuild vertices_ in track order from the curves' polylines wherever they are currently held
+        void PackRanges();
+
+        //! move curve i's polyline to a new range at the end of vertices_ if it has outgrown its own
+        void UpdateRange(std::size_t i);
 
     private:
-        //! bezier curves making up the track
+        //! bezier curves making up the track, in the order they were created
         std::vector< BezierCurve<> > curves_;
 
+        //! the circuit as links between curves, starting from curve first_
+        std::vector< std::size_t > next_, prev_;
+        std::size_t first_;
+
+        //! polylines of all curves, in track order after a full tessellation
+        std::vector< Vector3f > vertices_;
+
+        //! curve i's polyline starts at vertices_[ranges_[i].offset]
+        std::vector< Range > ranges_;
+
+        //! vertices left behind by polylines that moved to a bigger range
+        std::size_t unusedVertices_;
+
+        //! what changed in vertices_, for whoever keeps a copy of it
+        std::vector< unsigned int > curveVersions_;
+        unsigned int layoutVersion_;
+
         //! ships locked to the track
-        std::vector< Ship > ships_;
+        Ships ships_;
+
+        //! the ships on each curve, so that splitting a curve only visits its own ships
+        std::vector< std::vector< std::size_t > > shipsByCurve_;
+
+        //! where each ship is in its curve's list of ships
+        std::vector< std::size_t > shipEntries_;
+
+        //! the curve each ship was on before the current update
+        std::vector< std::size_t > previousCurves_;
+
+        //! PointAt's polynomial of every curve, Ships::POLYNOMIAL_SIZE floats each
+        std::vector<float> polynomials_;
+
+        //! arc length of every curve, with the longest on top for AddCurve to split
+        IndexedHeap<float> curveLengths_;
+
+        //! bounding volume hierarchy over curves_, built by the first Tessellate
+        BVH bvh_;
+        bool bvhBuilt_;
+
+        Tessellator tessellator_;
+        ThreadPool threadPool_;
 
-        //! cumulative arc lengths of curves
-        float length_;
+        //! arc lengths of the curves in track order, for converting between distances and curves
+        PrefixSumTree<float> distances_;
 
         const float ctrlPointRadius_; //!< radius of control point spheres
         bool ctrlPointSelected_; //!< is one of the curve's control points selected?
 
-        unsigned int selectedCurve_, affectedCurve_, selectedCtrlPoint_;
-        float zDistToPixel_; //!< range [0:1]
+        std::size_t selectedCurve_, affectedCurve_, selectedCtrlPoint_;
 
         std::size_t resolution_;
-        Vector4i viewport_;
+        static const std::size_t MAX_RESOLUTION = 4096;
+        static const std::size_t SHIPS_PER_TASK = 256; //!< a whole number of SSE ship blocks
+        BezierCurve<>::TessellationMode tessellationMode_;
+        float chordTolerance_; //!< max distance between curve and polyline in adaptive mode
     };
 }
 
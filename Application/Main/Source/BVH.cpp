@@ -0,0 +1,213 @@
+/*!
+    @file BVH.cpp @author Joel Barrett @date 16/10/26 @brief A bounding volume hierarchy over track curves.
+*/
+
+#include <algorithm>
+
+#include "BVH.h"
+
+namespace Application
+{
+    namespace
+    {
+        //! orders curves by the centre of their boxes along one axis
+        struct CentreLess
+        {
+            CentreLess(const std::vector< AABB<3> > &bounds, std::size_t axis): bounds(bounds), axis(axis){}
+
+            bool operator () (std::size_t i, std::size_t j) const
+            {
+                return bounds[i].GetMin()[axis] + bounds[i].GetMax()[axis] < 
+                       bounds[j].GetMin()[axis] + bounds[j].GetMax()[axis];
+            }
+
+            const std::vector< AABB<3> > &bounds;
+            std::size_t axis;
+        };
+    }
+
+    void BVH::Build(const std::vector< BezierCurve<> > &curves, float ctrlPointRadius)
+    {
+        ctrlPointRadius_ = ctrlPointRadius;
+
+        nodes_.clear();
+        nodes_.reserve(2 * curves.size());
+        order_.resize(curves.size());
+        leafBounds_.resize(curves.size());
+        leaves_.resize(curves.size());
+
+        for (std::size_t i = 0; i < curves.size(); ++i)
+        {
+            order_[i] = i;
+            leafBounds_[i] = LeafBounds(curves[i]);
+        }
+
+        if (!curves.empty()) {
+            BuildRange(0, curves.size(), -1);
+        }
+    }
+
+    int BVH::BuildRange(std::size_t first, std::size_t last, int parent)
+    {
+        int index = static_cast<int>(nodes_.size());
+        nodes_.push_back(Node());
+        nodes_[index].parent = parent;
+
+        if (last - first == 1)
+        {
+            nodes_[index].left = nodes_[index].right = -1;
+            nodes_[index].curve = order_[first];
+            nodes_[index].bounds = leafBounds_[order_[first]];
+            leaves_[order_[first]] = index;
+            return index;
+        }
+
+        // split at the median along the axis over which the box centres are most spread out
+        AABB<3> centres;
+        for (std::size_t i = first; i < last; ++i) {
+            centres.Extend(leafBounds_[order_[i]].GetCentre());
+        }
+
+        Vector3f extent = centres.GetExtent();
+        std::size_t axis = extent[0] > extent[1] ? (extent[0] > extent[2] ? 0 : 2) : (extent[1] > extent[2] ? 1 : 2);
+        std::size_t mid = first + (last - first) / 2;
+
+        std::nth_element(order_.begin() + first, order_.begin() + mid, order_.begin() + last, 
+            CentreLess(leafBounds_, axis));
+
+        int left = BuildRange(first, mid, index);
+        int right = BuildRange(mid, last, index);
+
+        // nodes_ may have been reallocated by the recursion
+        nodes_[index].left = left;
+        nodes_[index].right = right;
+        nodes_[index].bounds = nodes_[left].bounds;
+        nodes_[index].bounds.Extend(nodes_[right].bounds);
+
+        return index;
+    }
+
+    void BVH::Refit(const std::vector< BezierCurve<> > &curves, std::size_t i)
+    {
+        assert(i < leaves_.size());
+
+        int node = leaves_[i];
+        nodes_[node].bounds = LeafBounds(curves[i]);
+
+        for (node = nodes_[node].parent; node >= 0; node = nodes_[node].parent)
+        {
+            nodes_[node].bounds = nodes_[nodes_[node].left].bounds;
+            nodes_[node].bounds.Extend(nodes_[nodes_[node].right].bounds);
+        }
+    }
+
+    void BVH::Insert(const std::vector< BezierCurve<> > &curves, std::size_t i, std::size_t sibling)
+    {
+        assert(sibling < leaves_.size() && i < curves.size());
+
+        // the sibling's leaf becomes the parent of both halves, so the root stays at node 0
+        int parent = leaves_[sibling];
+        std::size_t depth = 0;
+        for (int node = parent; node > 0; node = nodes_[node].parent) {
+            ++depth;
+        }
+        if (depth >= MAX_INSERT_DEPTH)
+        {
+            Build(curves, ctrlPointRadius_);
+            return;
+        }
+
+        Node left, right;
+        left.parent = right.parent = parent;
+        left.left = left.right = right.left = right.right = -1;
+
+        left.curve = i;
+        left.bounds = LeafBounds(curves[i]);
+        right.curve = sibling;
+        right.bounds = LeafBounds(curves[sibling]);
+
+        leaves_.resize(Max(leaves_.size(), i + 1));
+        leaves_[i] = static_cast<int>(nodes_.size());
+        nodes_.push_back(left);
+        leaves_[sibling] = static_cast<int>(nodes_.size());
+        nodes_.push_back(right);
+
+        nodes_[parent].left = leaves_[i];
+        nodes_[parent].right = leaves_[sibling];
+
+        for (int node = parent; node >= 0; node = nodes_[node].parent)
+        {
+            nodes_[node].bounds = nodes_[nodes_[node].left].bounds;
+            nodes_[node].bounds.Extend(nodes_[nodes_[node].right].bounds);
+        }
+    }
+
+    void BVH::IntersectRay(const Ray<3> &ray, std::vector<std::size_t> &curves) const
+    {
+        curves.clear();
+        if (nodes_.empty()) {
+            return;
+        }
+
+        int stack[MAX_DEPTH];
+        std::size_t top = 0;
+        stack[top++] = 0;
+
+        while (top)
+        {
+            const Node &node = nodes_[stack[--top]];
+            if (!ray.TestAABB(node.bounds)) {
+                continue;
+            }
+
+            if (node.left < 0) {
+                curves.push_back(node.curve);
+            }
+            else
+            {
+                stack[top++] = node.left;
+                stack[top++] = node.right;
+            }
+        }
+        std::sort(curves.begin(), curves.end());
+    }
+
+    void BVH::IntersectAABB(const AABB<3> &box, std::vector<std::size_t> &curves) const
+    {
+        curves.clear();
+        if (nodes_.empty()) {
+            return;
+        }
+
+        int stack[MAX_DEPTH];
+        std::size_t top = 0;
+        stack[top++] = 0;
+
+        while (top)
+        {
+            const Node &node = nodes_[stack[--top]];
+            if (!box.Overlaps(node.bounds)) {
+                continue;
+            }
+
+            if (node.left < 0) {
+                curves.push_back(node.curve);
+            }
+            else
+            {
+                stack[top++] = node.left;
+                stack[top++] = node.right;
+            }
+        }
+        std::sort(curves.begin(), curves.end());
+    }
+
+    AABB<3> BVH::LeafBounds(const BezierCurve<> &curve) const
+    {
+        AABB<3> bounds = curve.GetBounds();
+        for (std::size_t i = 0; i < 4; ++i) {
+            bounds.Extend(curve.GetCtrlPoint(i), ctrlPointRadius_);
+        }
+        return bounds;
+    }
+}
@@ -8,16 +8,8 @@ namespace Application
 {
     Scene::~Scene()
     {
-        if (gridDisplayList_)
-        {
-            glDeleteLists(gridDisplayList_, 1);
-            gridDisplayList_ = NULL;
-        }
-        if (sphereDisplayList_)
-        {
-            glDeleteLists(sphereDisplayList_, 1);
-            sphereDisplayList_ = NULL;
-        }
+        simulation_.Stop();
+        renderer_.Release(device_);
     }
 
     void Scene::Init()
@@ -27,7 +19,8 @@ namespace Application
         InitWindow();
         InitEntities();
         InitOpenGL();
-        InitDisplayLists();
+
+        simulation_.Start(track_, settings_.simulation_.rate);
     }
 
     void Scene::Execute()
@@ -41,9 +34,13 @@ namespace Application
                 TranslateMessage(&msg);
                 DispatchMessage(&msg);
             }
-            else {
-                Update(0.01f);
-                Render();
+            else
+            {
+                float alpha;
+                const Simulation::Frame &frame = simulation_.AcquireFrame(alpha);
+
+                Update(frame, alpha);
+                Render(frame, alpha);
             }
         }
     }
@@ -68,7 +65,6 @@ namespace Application
                 GetSystemMetrics(SM_CYSCREEN) / 4, settings_.window_.width, settings_.window_.height);
             SetPixelFormatDescriptor(pixelFormat);
         }
-        Framework::Rendering::SetProcessorAffinity();
     }
 
     void Scene::InitEntities()
@@ -76,17 +72,14 @@ namespace Application
         if (!shipModel_.LoadModelData(settings_.modelFilename_.c_str())) {
             throw std::runtime_error("The file '" + settings_.modelFilename_ + "' couldn't be found");
         }
+        shipModel_.ReloadTextures(device_);
+        shipModel_.ReloadMeshes(device_);
+
         camera_.SetView(settings_.camera_.position, settings_.camera_.lookAt);
         camera_.ComputeFRU();
 
         // generate the track based on curves described in Settings.xml
-        std::vector< CurveSettings >::iterator it = settings_.track_.begin();
-        track_.AddFirstCurve(it->ctrlPoints[0], it->ctrlPoints[1], it->ctrlPoints[2], it->ctrlPoints[3]);
-        for (++it; it != settings_.track_.end(); ++it)
-        {
-            track_.AddCurveToEnd(it->ctrlPoints[0], it->ctrlPoints[1]);
-        }
-        track_.AddLastCurve();
+        settings_.BuildTrack(track_);
 
         light_.ambient = settings_.light_.ambient;
         light_.diffuse = settings_.light_.diffuse;
@@ -95,176 +88,81 @@ namespace Application
 
     void Scene::InitOpenGL()
     {
-        glHint(GL_PERSPECTIVE_CORRECTION_HINT, GL_NICEST);
-        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
-        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
-        glClearDepth(1.0f);
-        glDepthFunc(GL_LEQUAL);
-        glDepthMask(GL_TRUE);
-        glShadeModel(GL_SMOOTH);
-
-        glEnable(GL_CULL_FACE);
-        glEnable(GL_DEPTH_TEST);
-        glEnable(GL_COLOR_MATERIAL);
-        glEnable(GL_LIGHT1);
-
-        glLightfv(GL_LIGHT1, GL_AMBIENT, &light_.ambient[0]);
-        glLightfv(GL_LIGHT1, GL_DIFFUSE, &light_.diffuse[0]);
-        glLightfv(GL_LIGHT1, GL_POSITION, &light_.position[0]);
-
-        glMatrixMode(GL_PROJECTION);
-        glLoadIdentity();
-        gluPerspective(45.0, width_ / static_cast<GLdouble>(height_), 0.1, 500.0);
-    }
+        device_.Init();
 
-    void Scene::InitDisplayLists()
-    {
-        // setup control point spheres display list
-        sphereDisplayList_ = glGenLists(1);
-        glNewList(sphereDisplayList_, GL_COMPILE);
-        GLUquadric* ctrlPointQuadric = gluNewQuadric();
-        gluSphere(ctrlPointQuadric, track_.GetCtrlPointRadius(), 32, 16);
-        gluDeleteQuadric(ctrlPointQuadric);
-        glEndList();
-
-        // setup grid display list
-        gridDisplayList_ = glGenLists(1);
-        glNewList(gridDisplayList_, GL_COMPILE);
-        glBegin(GL_LINES);
-        glPushMatrix();
-        glColor3f(0.2f, 0.2f, 0.2f);
-
-        for (int i = -20; i <= 20; ++i)
-        {
-            // x-axis
-            glVertex3i(i, 0, -20);
-            glVertex3i(i, 0,  20);
+        // the light is fixed in eye space, set while the modelview matrix is the identity
+        device_.SetLight(light_);
+        device_.SetProjection(45.0f, width_ / static_cast<float>(height_), 0.1f, 500.0f);
 
-            // z-axis
-            glVertex3i(-20, 0, i);
-            glVertex3i( 20, 0, i);
-        }
-        glPopMatrix();
-        glEnd();
-        glEndList();
+        renderer_.Init(device_, track_.GetCtrlPointRadius());
     }
 
-    void Scene::Update(float dt)
+    void Scene::Update(const Simulation::Frame &frame, float alpha)
     {
+        // a ship only just added has yet to be stepped
+        if (frame.current.empty()) {
+            return;
+        }
+        Simulation::ShipState ship = frame.Interpolate(0, alpha);
+
         static Vector3f newCameraPos;
         switch (camera_.GetMode())
         {
         case Camera::CAMERA_MODE_1ST:
-            newCameraPos = track_.GetShip(0).pos + Vector3f(0.0f, 0.4f, 0.0f);
-            camera_.SetView(newCameraPos, newCameraPos + Normalised(track_.GetShip(0).heading));
+            newCameraPos = ship.pos + Vector3f(0.0f, 0.4f, 0.0f);
+            camera_.SetView(newCameraPos, newCameraPos + ship.heading);
             break;
 
         case Camera::CAMERA_MODE_3RD:
-            camera_.SetViewToTarget(track_.GetShip(0).pos - track_.GetShip(0).heading * 
-                4.0f + Vector3f(0.0f, 2.0f, 0.0f), track_.GetShip(0).pos);
+            camera_.SetViewToTarget(ship.pos - ship.heading * 4.0f + Vector3f(0.0f, 2.0f, 0.0f), ship.pos);
             break;
         }
-        track_.Update(dt);
     }
 
-    void Scene::Render()
+    void Scene::Render(const Simulation::Frame &frame, float alpha)
     {
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        glMatrixMode(GL_MODELVIEW);
-        glLoadIdentity();
-        //glLoadMatrixf(camera_.GetViewMatrix());
-        gluLookAt(camera_.GetPosition().x(), camera_.GetPosition().y(), camera_.GetPosition().z(),
-            camera_.GetLook().x(), camera_.GetLook().y(), camera_.GetLook().z(),
-            camera_.GetUp().x(), camera_.GetUp().y(), camera_.GetUp().z());
-        glCallList(gridDisplayList_);
-
-        RenderTrack();
-        RenderCPLines();
-        RenderCPSpheres();
-        RenderShips();
-
+        renderer_.Render(device_, camera_, track_, frame, alpha, shipModel_);
         SwapBuffers(hDC_);
     }
 
-    void Scene::RenderTrack()
+    void Scene::SelectCtrlPoint(int x, int y)
     {
-        glBegin(GL_LINE_STRIP);
-        glPushMatrix();
-        glColor3f(0.8f, 0.8f, 0.8f);
-        for (std::size_t i = 0; i < track_.GetNumCurves(); ++i)
-        {
-            for (std::size_t j = 0; j < track_.GetCurve(i).GetResolution(); ++j) {
-                glVertex3fv(&track_.GetCurve(i).GetPolylineVert(j).x());
-            }
-        }
-        glVertex3fv(&track_.GetCurve(0).GetPolylineVert(0).x());
-        glPopMatrix();
-        glEnd();
-    }
+        static float redValue = 0.0f;
+        glGetIntegerv(GL_VIEWPORT, &viewport_[0]);
+        GLint gl_y = viewport_[3] - y - 1;
 
-    void Scene::RenderCPLines()
-    {
-        glBegin(GL_LINES);
-        glPushMatrix();
-        glColor3fv(Colour::red);
-        for (std::size_t i = 0; i < track_.GetNumCurves(); ++i)
-        {
-            glVertex3fv(&track_.GetCurve(i).GetCtrlPoint(0).x());
-            glVertex3fv(&track_.GetCurve(i).GetCtrlPoint(1).x());
-            glVertex3fv(&track_.GetCurve(i).GetCtrlPoint(2).x());
-            glVertex3fv(&track_.GetCurve(i).GetCtrlPoint(3).x());
-        }
-        glPopMatrix();
-        glEnd();
-    }
-
-    void Scene::RenderCPSpheres()
-    {
-        glMaterialfv(GL_FRONT, GL_EMISSION, Colour::black);
-        glColor3fv(Colour::red);
+        glReadPixels(x, gl_y, 1, 1, GL_RED, GL_FLOAT, &redValue);
+        glReadPixels(x, gl_y, 1, 1, GL_DEPTH_COMPONENT, GL_FLOAT, &zDistToPixel_);
 
-        glEnable(GL_LIGHTING);
-        for (std::size_t i = 0; i < track_.GetNumCurves(); ++i)
+        if (redValue)
         {
-            for (std::size_t j = 0; j < (track_.GetCurve(i).GetDegree() - 1); ++j)
-            {
-                glPushMatrix();
-                glTranslatef(track_.GetCurve(i).GetCtrlPoint(j).x(), track_.GetCurve(i).GetCtrlPoint(j).y(), 
-                    track_.GetCurve(i).GetCtrlPoint(j).z());
-                glCallList(sphereDisplayList_);
-                glPopMatrix();
-            }
+            // compute the direction vector of ray in world space
+            Vector3f temp = Normalised(ScreenToViewX<float>((float)x, (float)width_, (float)height_) * -camera_.GetRight() + 
+                                       ScreenToViewY<float>((float)y, (float)width_, (float)height_) * camera_.GetDown() - camera_.GetForward());
+
+            track_.SelectCtrlPoint(Ray<3>(camera_.GetPosition(), temp));
         }
-        glDisable(GL_LIGHTING);
     }
 
-    void Scene::RenderShips()
+    void Scene::DragCtrlPoint(int x, int y)
     {
-        Vector3f axis;
-        float angle = 0.0f, anglep = 0.0f, angley = 0.0f;
-
-        glEnable(GL_LIGHTING);
-        glColor3f(0.6f, 0.6f, 0.6f);
-
-        for (std::size_t i = 0; i < track_.GetNumShips(); ++i)
+        // if camera isn't too close to the sphere
+        if (zDistToPixel_ > 0.8f)
         {
-            // angle between direction of ship and x-axis in degrees
-            angle = Angle(track_.GetShip(i).heading, Vector3f::UNIT_X) * Const<float>::TO_DEG;
+            static Vector3d move;
+            static Matrix4x4d view, proj;
 
-            // axis of rotation is cross product of ship's heading and negative unit x
-            axis = Normalised(Cross(track_.GetShip(i).heading, -Vector3f::UNIT_X));
+            // get view matrix and projection matrix
+            glGetDoublev(GL_MODELVIEW_MATRIX, &view[0][0]);
+            glGetDoublev(GL_PROJECTION_MATRIX, &proj[0][0]);
 
-            glPushMatrix();
-            glTranslatef(track_.GetShip(i).pos.x(), track_.GetShip(i).pos.y(), track_.GetShip(i).pos.z());
-            glRotatef(angle, axis.x(), axis.y(), axis.z());
+            // transform mouse coordinates into world space
+            gluUnProject(x, viewport_[3] - y - 1, zDistToPixel_, &view[0][0], &proj[0][0], 
+                &viewport_[0], &move.x(), &move.y(), &move.z());
 
-            // don't render the first ship when player is looking out its cockpit
-            if (!(camera_.GetMode() == Camera::CAMERA_MODE_1ST && i == 0)) {
-                shipModel_.Draw();
-            }
-            glPopMatrix();
+            std::unique_lock<std::mutex> lock = simulation_.Lock();
+            track_.DragCtrlPoint(move);
         }
-        glDisable(GL_LIGHTING);
     }
 
     LRESULT CALLBACK Scene::MsgRouter(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
@@ -283,7 +181,7 @@ namespace Application
                 mousePos.y = HIWORD(lParam);
 
                 if (track_.IsCtrlPointSelected()) {
-                    track_.DragCtrlPoint(mousePos.x, mousePos.y);
+                    DragCtrlPoint(mousePos.x, mousePos.y);
                 }
                 if (mouseRight) {
                     camera_.SetViewByMouse(static_cast<float>(prevMousePos.x) - mousePos.x, 
@@ -298,7 +196,7 @@ namespace Application
 
             // test for control point selection if in god mode and not moving camera
             if (camera_.ModeEquals(Camera::CAMERA_MODE_GOD) && !mouseRight) {
-                track_.SelectCtrlPoint(camera_, width_, height_, mousePos.x, mousePos.y);
+                SelectCtrlPoint(mousePos.x, mousePos.y);
             }
             break;
 
@@ -336,6 +234,7 @@ namespace Application
                     camera_.SetMode(Camera::CAMERA_MODE_1ST);
 
                     if (!track_.GetNumShips()) {
+                        std::unique_lock<std::mutex> lock = simulation_.Lock();
                         track_.AddShip();
                     }
                     cameraPos = camera_.GetPosition();
@@ -364,24 +263,28 @@ namespace Application
 
             case VK_UP:
                 if (camera_.ModeEquals(Camera::CAMERA_MODE_GOD)) {
+                    std::unique_lock<std::mutex> lock = simulation_.Lock();
                     track_.IncResolution();
                 }
                 break;
 
             case VK_DOWN:
                 if (camera_.ModeEquals(Camera::CAMERA_MODE_GOD)) {
+                    std::unique_lock<std::mutex> lock = simulation_.Lock();
                     track_.DecResolution();
                 }
                 break;
 
             case 0x43: // 'C'
                 if (camera_.ModeEquals(Camera::CAMERA_MODE_GOD)) {
+                    std::unique_lock<std::mutex> lock = simulation_.Lock();
                     track_.AddCurve();
                 }
                 break;
 
             case 0x45: // 'E'
                 if (camera_.ModeEquals(Camera::CAMERA_MODE_GOD)) {
+                    std::unique_lock<std::mutex> lock = simulation_.Lock();
                     track_.AddShip();
                 }
                 break;
@@ -392,9 +295,17 @@ namespace Application
 
             case 0x52: // 'R'
                 if (camera_.ModeEquals(Camera::CAMERA_MODE_GOD)) {
+                    std::unique_lock<std::mutex> lock = simulation_.Lock();
                     track_.RemoveShip();
                 }
                 break;
+
+            case 0x54: // 'T'
+                if (camera_.ModeEquals(Camera::CAMERA_MODE_GOD)) {
+                    std::unique_lock<std::mutex> lock = simulation_.Lock();
+                    track_.ToggleTessellationMode();
+                }
+                break;
             }
             break;
 
@@ -0,0 +1,427 @@
+/*!
+    @file SceneRenderer.cpp @author Joel Barrett @date 16/10/26 @brief Builds frames of the scene on a render device.
+*/
+
+#include <algorithm>
+
+#include "SceneRenderer.h"
+#include "Colour.h"
+
+namespace Application
+{
+    namespace
+    {
+        const float GRID_COLOUR[3] = {0.2f, 0.2f, 0.2f};
+        const float TRACK_COLOUR[3] = {0.8f, 0.8f, 0.8f};
+        const float SHIP_COLOUR[3] = {0.6f, 0.6f, 0.6f};
+
+        // OpenGL's default material, which clears the emission a ship's material leaves behind;
+        // ambient and diffuse follow the colour regardless
+        const float SPHERE_AMBIENT[4] = {0.2f, 0.2f, 0.2f, 1.0f};
+        const float SPHERE_DIFFUSE[4] = {0.8f, 0.8f, 0.8f, 1.0f};
+        const float SPHERE_SPECULAR[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+        const float SPHERE_EMISSIVE[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+
+        //! a heading this close to -x, in y^2 + z^2, is taken as turned right round
+        const float REVERSED_EPSILON = 1e-20f;
+
+        const int GRID_HALF_SIZE = 20;
+        const std::size_t SPHERE_SLICES = 32, SPHERE_STACKS = 16;
+
+        //! the model matrix that turns a ship's x-axis onto its unit heading and moves it to pos; the
+        //! rotation is the one about x cross heading the ships were turned by with an angle, written
+        //! out so that it takes no trigonometry, and a ship heading back along x is turned about y
+        void StoreTransform(const Vector3f &pos, const Vector3f &heading, RenderDevice::Instance &instance)
+        {
+            float hx = heading.x(), hy = heading.y(), hz = heading.z();
+            float* m = instance.matrix;
+
+            // k is 1/(1 + hx), which loses precision as the heading turns back along x, where
+            // (1 - hx)/(y^2 + z^2) is its equal for a unit heading
+            float s = hy*hy + hz*hz;
+            bool reversed = hx < 0.0f && s < REVERSED_EPSILON;
+            float k = reversed ? 0.0f : (hx >= 0.0f ? 1.0f / (1.0f + hx) : (1.0f - hx) / s);
+
+            // columns of the rotation, then the translation
+            m[0] = hx; m[1] = hy; m[2] = hz; m[3] = 0.0f;
+            m[4] = -hy; m[5] = 1.0f - k*hy*hy; m[6] = -k*hy*hz; m[7] = 0.0f;
+            m[8] = -hz; m[9] = -k*hy*hz; m[10] = reversed ? -1.0f : 1.0f - k*hz*hz; m[11] = 0.0f;
+            m[12] = pos.x(); m[13] = pos.y(); m[14] = pos.z(); m[15] = 1.0f;
+        }
+
+        //! unit point on a sphere about the z-axis, at polar angle phi and azimuth theta
+        Vector3f SpherePoint(float phi, float theta)
+        {
+            return Vector3f(sin(phi) * cos(theta), sin(phi) * sin(theta), cos(phi));
+        }
+
+        //! triangles of a sphere as gluSphere would tessellate it, wound anticlockwise from outside
+        void BuildSphere(float radius, std::size_t slices, std::size_t stacks, std::vector< RenderDevice::Vertex > &verts)
+        {
+            RenderDevice::Vertex v = RenderDevice::Vertex();
+            for (std::size_t i = 0; i < stacks; ++i)
+            {
+                float phi0 = Const<float>::PI * i / stacks, phi1 = Const<float>::PI * (i + 1) / stacks;
+                for (std::size_t j = 0; j < slices; ++j)
+                {
+                    float theta0 = 2.0f * Const<float>::PI * j / slices, theta1 = 2.0f * Const<float>::PI * (j + 1) / slices;
+                    Vector3f quad[4] = { SpherePoint(phi0, theta0), SpherePoint(phi1, theta0),
+                                         SpherePoint(phi1, theta1), SpherePoint(phi0, theta1) };
+
+                    // the quads at the poles are single triangles
+                    const std::size_t corners[6] = { 0, 1, 2, 0, 2, 3 };
+                    std::size_t begin = (i == stacks - 1) ? 3 : 0, end = (i == 0) ? 3 : 6;
+
+                    for (std::size_t k = begin; k < end; ++k)
+                    {
+                        v.normal = quad[corners[k]];
+                        v.position = quad[corners[k]] * radius;
+                        verts.push_back(v);
+                    }
+                }
+            }
+        }
+    }
+
+    SceneRenderer::SceneRenderer()
+        : gridMesh_(0), sphereMesh_(0), trackVertices_(0), trackIndices_(0), ctrlPoints_(0),
+          trackVertexCapacity_(0), trackIndexCapacity_(0), ctrlPointCapacity_(0), numTrackIndices_(0),
+          layoutVersion_(0){}
+
+    void SceneRenderer::Init(RenderDevice &device, float ctrlPointRadius)
+    {
+        std::vector< RenderDevice::Vertex > sphere;
+        BuildSphere(ctrlPointRadius, SPHERE_SLICES, SPHERE_STACKS, sphere);
+        sphereMesh_ = device.CreateMesh(RenderDevice::PRIMITIVE_TRIANGLES, &sphere[0], sphere.size());
+
+        std::vector< Vector3f > grid;
+        for (int i = -GRID_HALF_SIZE; i <= GRID_HALF_SIZE; ++i)
+        {
+            float x = static_cast<float>(i), extent = static_cast<float>(GRID_HALF_SIZE);
+
+            // x-axis
+            grid.push_back(Vector3f(x, 0.0f, -extent));
+            grid.push_back(Vector3f(x, 0.0f,  extent));
+
+            // z-axis
+            grid.push_back(Vector3f(-extent, 0.0f, x));
+            grid.push_back(Vector3f( extent, 0.0f, x));
+        }
+        gridMesh_ = device.CreateMesh(RenderDevice::PRIMITIVE_LINES, &grid[0], grid.size());
+    }
+
+    void SceneRenderer::Release(RenderDevice &device)
+    {
+        if (gridMesh_)
+        {
+            device.DestroyMesh(gridMesh_);
+            gridMesh_ = 0;
+        }
+        if (sphereMesh_)
+        {
+            device.DestroyMesh(sphereMesh_);
+            sphereMesh_ = 0;
+        }
+
+        RenderDevice::Buffer* buffers[3] = { &trackVertices_, &trackIndices_, &ctrlPoints_ };
+        for (std::size_t i = 0; i < 3; ++i)
+        {
+            if (*buffers[i])
+            {
+                device.DestroyBuffer(*buffers[i]);
+                *buffers[i] = 0;
+            }
+        }
+        trackVertexCapacity_ = trackIndexCapacity_ = ctrlPointCapacity_ = numTrackIndices_ = 0;
+
+        // the next frame writes everything again
+        curveVersions_.clear();
+        curveOffsets_.clear();
+        curveCounts_.clear();
+    }
+
+    void SceneRenderer::Render(RenderDevice &device, const Camera &camera, const Track &track,
+        const Simulation::Frame &frame, float alpha, Model &shipModel)
+    {
+        device.Clear();
+        device.SetView(camera.GetPosition(), camera.GetLook(), camera.GetUp());
+
+        device.SetColour(GRID_COLOUR);
+        device.DrawMesh(gridMesh_);
+
+        UpdateTrackBuffers(device, track);
+        RenderTrack(device);
+        RenderCPLines(device, track);
+        RenderCPSpheres(device, track);
+        RenderShips(device, camera, frame, alpha, shipModel);
+    }
+
+    void SceneRenderer::UpdateTrackBuffers(RenderDevice &device, const Track &track)
+    {
+        std::size_t numCurves = track.GetNumCurves(), known = curveVersions_.size();
+
+        // once the ranges have been laid out again, or the track has outgrown the buffers, the whole pool
+        // is written again; otherwise only the curves recomputed in place or moved to the end of it are
+        if (track.GetLayoutVersion() != layoutVersion_ || numCurves < known ||
+            track.GetNumVertices() > trackVertexCapacity_ || numCurves * 4 > ctrlPointCapacity_)
+        {
+            ReserveBuffer(device, trackVertices_, trackVertexCapacity_, track.GetNumVertices(), false);
+            if (track.GetNumVertices()) {
+                device.UpdateVertexBuffer(trackVertices_, 0, track.GetVertices(), track.GetNumVertices());
+            }
+
+            lineVerts_.clear();
+            for (std::size_t i = 0; i < numCurves; ++i)
+            {
+                for (std::size_t j = 0; j < 4; ++j) {
+                    lineVerts_.push_back(track.GetCurve(i).GetCtrlPoint(j));
+                }
+            }
+            ReserveBuffer(device, ctrlPoints_, ctrlPointCapacity_, lineVerts_.size(), false);
+            if (!lineVerts_.empty()) {
+                device.UpdateVertexBuffer(ctrlPoints_, 0, &lineVerts_[0], lineVerts_.size());
+            }
+
+            curveVersions_.resize(numCurves);
+            curveOffsets_.resize(numCurves);
+            curveCounts_.resize(numCurves);
+            for (std::size_t i = 0; i < numCurves; ++i)
+            {
+                curveVersions_[i] = track.GetCurveVersion(i);
+                curveOffsets_[i] = track.GetVertexOffset(i);
+                curveCounts_[i] = track.GetVertexCount(i);
+            }
+            layoutVersion_ = track.GetLayoutVersion();
+
+            UpdateTrackIndices(device, track);
+            return;
+        }
+
+        // a new curve is linked into the middle of the strip
+        bool indicesChanged = numCurves != known;
+        curveVersions_.resize(numCurves);
+        curveOffsets_.resize(numCurves);
+        curveCounts_.resize(numCurves);
+
+        for (std::size_t i = 0; i < numCurves; ++i)
+        {
+            if (i < known && track.GetCurveVersion(i) == curveVersions_[i]) {
+                continue;
+            }
+
+            // a range is never shorter than the polyline it holds, and the buffer holds the whole pool,
+            // so the write stays inside both
+            std::size_t offset = track.GetVertexOffset(i), count = track.GetVertexCount(i);
+            if (count) {
+                device.UpdateVertexBuffer(trackVertices_, offset, track.GetVertices() + offset, count);
+            }
+
+            Vector3f ctrlPoints[4];
+            for (std::size_t j = 0; j < 4; ++j) {
+                ctrlPoints[j] = track.GetCurve(i).GetCtrlPoint(j);
+            }
+            device.UpdateVertexBuffer(ctrlPoints_, i * 4, ctrlPoints, 4);
+
+            // an adaptive polyline can shrink or grow within its range, and one that outgrows it moves
+            indicesChanged = indicesChanged || count != curveCounts_[i] || offset != curveOffsets_[i];
+            curveVersions_[i] = track.GetCurveVersion(i);
+            curveOffsets_[i] = offset;
+            curveCounts_[i] = count;
+        }
+
+        if (indicesChanged) {
+            UpdateTrackIndices(device, track);
+        }
+    }
+
+    void SceneRenderer::UpdateTrackIndices(RenderDevice &device, const Track &track)
+    {
+        indices_.clear();
+        if (track.GetNumCurves())
+        {
+            std::size_t first = track.GetFirstCurve(), i = first;
+            do
+            {
+                std::size_t offset = track.GetVertexOffset(i);
+                for (std::size_t j = 0; j < track.GetVertexCount(i); ++j) {
+                    indices_.push_back(static_cast<unsigned int>(offset + j));
+                }
+                i = track.GetNextCurve(i);
+            } while (i != first);
+            indices_.push_back(static_cast<unsigned int>(track.GetVertexOffset(first)));
+        }
+
+        ReserveBuffer(device, trackIndices_, trackIndexCapacity_, indices_.size(), true);
+        if (!indices_.empty()) {
+            device.UpdateIndexBuffer(trackIndices_, 0, &indices_[0], indices_.size());
+        }
+        numTrackIndices_ = indices_.size();
+    }
+
+    void SceneRenderer::ReserveBuffer(RenderDevice &device, RenderDevice::Buffer &buffer, std::size_t &capacity,
+        std::size_t count, bool indices)
+    {
+        if (buffer && count <= capacity) {
+            return;
+        }
+        if (buffer) {
+            device.DestroyBuffer(buffer);
+        }
+
+        // room to grow, so that adding curves one at a time doesn't recreate the buffer every time
+        capacity = std::max< std::size_t >(count + count / 2, 64);
+        buffer = indices ? device.CreateIndexBuffer(capacity) : device.CreateVertexBuffer(capacity);
+    }
+
+    void SceneRenderer::RenderTrack(RenderDevice &device)
+    {
+        if (!numTrackIndices_) {
+            return;
+        }
+
+        device.SetColour(TRACK_COLOUR);
+        device.DrawIndexed(RenderDevice::PRIMITIVE_LINE_STRIP, trackVertices_, trackIndices_, numTrackIndices_);
+    }
+
+    void SceneRenderer::RenderCPLines(RenderDevice &device, const Track &track)
+    {
+        if (!track.GetNumCurves()) {
+            return;
+        }
+
+        // the handles from each end of a curve to the control point beside it
+        device.SetColour(Colour::red);
+        device.DrawBuffer(RenderDevice::PRIMITIVE_LINES, ctrlPoints_, 0, track.GetNumCurves() * 4);
+    }
+
+    void SceneRenderer::RenderCPSpheres(RenderDevice &device, const Track &track)
+    {
+        device.SetMaterial(SPHERE_AMBIENT, SPHERE_DIFFUSE, SPHERE_SPECULAR, SPHERE_EMISSIVE, 0.0f);
+        device.SetColour(Colour::red);
+
+        device.SetLighting(true);
+        for (std::size_t i = 0; i < track.GetNumCurves(); ++i)
+        {
+            for (std::size_t j = 0; j < (track.GetCurve(i).GetDegree() - 1); ++j)
+            {
+                device.PushMatrix();
+                device.Translate(track.GetCurve(i).GetCtrlPoint(j));
+                device.DrawMesh(sphereMesh_);
+                device.PopMatrix();
+            }
+        }
+        device.SetLighting(false);
+    }
+
+    void SceneRenderer::RenderShips(RenderDevice &device, const Camera &camera,
+        const Simulation::Frame &frame, float alpha, Model &shipModel)
+    {
+        BuildInstances(frame, alpha);
+
+        // don't render the first ship when player is looking out its cockpit
+        std::size_t first = (camera.GetMode() == Camera::CAMERA_MODE_1ST) ? 1 : 0;
+        if (instances_.size() <= first) {
+            return;
+        }
+
+        device.SetLighting(true);
+        device.SetColour(SHIP_COLOUR);
+        shipModel.DrawInstanced(device, &instances_[first], static_cast<int>(instances_.size() - first));
+        device.SetLighting(false);
+    }
+
+    void SceneRenderer::BuildInstances(const Simulation::Frame &frame, float alpha)
+    {
+        instances_.resize(frame.current.size());
+
+        // ships added since the step before have nothing to interpolate from, and are left to the scalar path
+        std::size_t i = 0;
+#ifdef MATHS_SIMD_X86
+        if (GetSimdLevel() >= SIMD_SSE)
+        {
+            std::size_t last = std::min(frame.current.size(), frame.previous.size());
+            for (; i + 4 <= last; i += 4) {
+                BuildInstancesSSE(frame, alpha, i);
+            }
+        }
+#endif
+        BuildInstancesScalar(frame, alpha, i, frame.current.size());
+    }
+
+    void SceneRenderer::BuildInstancesScalar(const Simulation::Frame &frame, float alpha, std::size_t first, std::size_t last)
+    {
+        for (std::size_t i = first; i < last; ++i)
+        {
+            Simulation::ShipState ship = frame.Interpolate(i, alpha);
+
+            // a ship with no heading faces along x
+            if (IsZero(ship.heading)) {
+                ship.heading = Vector3f::UNIT_X;
+            }
+            StoreTransform(ship.pos, ship.heading, instances_[i]);
+        }
+    }
+
+#ifdef MATHS_SIMD_X86
+    void SceneRenderer::BuildInstancesSSE(const Simulation::Frame &frame, float alpha, std::size_t first)
+    {
+        const Simulation::ShipState* current = &frame.current[first], *previous = &frame.previous[first];
+        __m128 a = _mm_set1_ps(alpha);
+
+        // as Frame::Interpolate, four ships at a time
+        __m128 pos[3], heading[3];
+        for (std::size_t k = 0; k < 3; ++k)
+        {
+            __m128 p0 = _mm_setr_ps(previous[0].pos[k], previous[1].pos[k], previous[2].pos[k], previous[3].pos[k]);
+            __m128 p1 = _mm_setr_ps(current[0].pos[k], current[1].pos[k], current[2].pos[k], current[3].pos[k]);
+            __m128 h0 = _mm_setr_ps(previous[0].heading[k], previous[1].heading[k], previous[2].heading[k], previous[3].heading[k]);
+            __m128 h1 = _mm_setr_ps(current[0].heading[k], current[1].heading[k], current[2].heading[k], current[3].heading[k]);
+
+            pos[k] = _mm_add_ps(p0, _mm_mul_ps(_mm_sub_ps(p1, p0), a));
+            heading[k] = _mm_add_ps(h0, _mm_mul_ps(_mm_sub_ps(h1, h0), a));
+        }
+
+        // normalise, with a null heading facing along x
+        __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+        __m128 magSqr = _mm_add_ps(_mm_add_ps(_mm_mul_ps(heading[0], heading[0]),
+            _mm_mul_ps(heading[1], heading[1])), _mm_mul_ps(heading[2], heading[2]));
+        __m128 null = _mm_cmpeq_ps(magSqr, zero);
+        __m128 inv = _mm_div_ps(one, _mm_sqrt_ps(_mm_or_ps(_mm_and_ps(null, one), _mm_andnot_ps(null, magSqr))));
+
+        __m128 hx = _mm_or_ps(_mm_and_ps(null, one), _mm_andnot_ps(null, _mm_mul_ps(heading[0], inv)));
+        __m128 hy = _mm_andnot_ps(null, _mm_mul_ps(heading[1], inv));
+        __m128 hz = _mm_andnot_ps(null, _mm_mul_ps(heading[2], inv));
+
+        // as StoreTransform, choosing k's form by the sign of hx
+        __m128 s = _mm_add_ps(_mm_mul_ps(hy, hy), _mm_mul_ps(hz, hz));
+        __m128 behind = _mm_cmplt_ps(hx, zero);
+        __m128 reversed = _mm_and_ps(behind, _mm_cmplt_ps(s, _mm_set1_ps(REVERSED_EPSILON)));
+
+        __m128 num = _mm_or_ps(_mm_and_ps(behind, _mm_sub_ps(one, hx)), _mm_andnot_ps(behind, one));
+        __m128 den = _mm_or_ps(_mm_and_ps(behind, s), _mm_andnot_ps(behind, _mm_add_ps(one, hx)));
+        den = _mm_or_ps(_mm_and_ps(reversed, one), _mm_andnot_ps(reversed, den));
+        __m128 k = _mm_andnot_ps(reversed, _mm_div_ps(num, den));
+
+        __m128 khy = _mm_mul_ps(k, hy);
+        __m128 m5 = _mm_sub_ps(one, _mm_mul_ps(khy, hy));
+        __m128 m6 = _mm_sub_ps(zero, _mm_mul_ps(khy, hz));
+        __m128 m10 = _mm_sub_ps(one, _mm_mul_ps(_mm_mul_ps(k, hz), hz));
+        m10 = _mm_or_ps(_mm_and_ps(reversed, _mm_set1_ps(-1.0f)), _mm_andnot_ps(reversed, m10));
+
+        // the matrices a column of four ships at a time, transposed into each ship's column
+        __m128 columns[4][4] = {
+            { hx, hy, hz, zero },
+            { _mm_sub_ps(zero, hy), m5, m6, zero },
+            { _mm_sub_ps(zero, hz), m6, m10, zero },
+            { pos[0], pos[1], pos[2], one }
+        };
+        for (std::size_t c = 0; c < 4; ++c)
+        {
+            _MM_TRANSPOSE4_PS(columns[c][0], columns[c][1], columns[c][2], columns[c][3]);
+            for (std::size_t j = 0; j < 4; ++j) {
+                _mm_storeu_ps(instances_[first + j].matrix + c * 4, columns[c][j]);
+            }
+        }
+    }
+#endif
+}
@@ -3,6 +3,7 @@
 */
 
 #include "Settings.h"
+#include "Track.h"
 
 #pragma warning (push)
 #pragma warning (disable : 4244)
@@ -68,6 +69,16 @@ namespace Application
                                       atof(pNode->FirstChild("Y")->ToElement()->GetText()),
                                       atof(pNode->FirstChild("Z")->ToElement()->GetText()));
         }
+
+        // Simulation, stepped 100 times a second unless the file says otherwise
+        {
+            TiXmlElement* pNode = hRoot.FirstChild("Simulation").FirstChild("Rate").ToElement();
+            simulation_.rate = pNode ? atof(pNode->GetText()) : 100.0f;
+
+            if (simulation_.rate <= 0.0f) {
+                throw std::runtime_error("The file '" + std::string(pFilename) + "' specifies a simulation rate that isn't positive");
+            }
+        }
         
         // Track
         {
@@ -113,6 +124,18 @@ namespace Application
                                        atof(pNode->FirstChild("Z")->ToElement()->GetText()));
         }
     }
+
+    void Settings::BuildTrack(Track &track) const
+    {
+        std::vector< CurveSettings >::const_iterator it = track_.begin();
+        track.AddFirstCurve(it->ctrlPoints[0], it->ctrlPoints[1], it->ctrlPoints[2], it->ctrlPoints[3]);
+        for (++it; it != track_.end(); ++it)
+        {
+            track.AddCurveToEnd(it->ctrlPoints[0], it->ctrlPoints[1]);
+        }
+        track.AddLastCurve();
+        track.Tessellate();
+    }
 }
 
 #pragma warning (pop)
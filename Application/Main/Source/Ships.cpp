@@ -0,0 +1,165 @@
+/*!
+    @file Ships.cpp @author Joel Barrett @date 16/10/26 @brief Structure-of-arrays storage for the ships on a track.
+*/
+
+#include "Ships.h"
+
+namespace Application
+{
+    void Ships::push_back(const Vector3f &pos, const Vector3f &heading, std::size_t curve, float t)
+    {
+        t_.push_back(t);
+        speed_.push_back(2.0f);
+        energy_.push_back(0.0f);
+        curve_.push_back(curve);
+
+        for (std::size_t k = 0; k < 3; ++k)
+        {
+            pos_[k].push_back(pos[k]);
+            heading_[k].push_back(heading[k]);
+        }
+    }
+
+    void Ships::pop_back()
+    {
+        assert(!empty());
+
+        t_.pop_back();
+        speed_.pop_back();
+        energy_.pop_back();
+        curve_.pop_back();
+
+        for (std::size_t k = 0; k < 3; ++k)
+        {
+            pos_[k].pop_back();
+            heading_[k].pop_back();
+        }
+    }
+
+    void Ships::ComputeEnergy(float gravity, std::size_t first, std::size_t last)
+    {
+        assert(first <= last && last <= size());
+
+        std::size_t i = first;
+#ifdef MATHS_SIMD_X86
+        if (GetSimdLevel() >= SIMD_SSE)
+        {
+            for (; i + 4 <= last; i += 4) {
+                ComputeEnergySSE(i, gravity);
+            }
+        }
+#endif
+        ComputeEnergyScalar(i, last, gravity);
+    }
+
+    void Ships::Evaluate(const float* polynomials, float gravity, std::size_t first, std::size_t last)
+    {
+        assert(first <= last && last <= size());
+
+        std::size_t i = first;
+#ifdef MATHS_SIMD_X86
+        if (GetSimdLevel() >= SIMD_SSE)
+        {
+            for (; i + 4 <= last; i += 4) {
+                EvaluateSSE(i, polynomials, gravity);
+            }
+        }
+#endif
+        EvaluateScalar(i, last, polynomials, gravity);
+    }
+
+    void Ships::ComputeEnergyScalar(std::size_t first, std::size_t last, float gravity)
+    {
+        for (std::size_t i = first; i < last; ++i) {
+            energy_[i] = 0.5f * Sqr(speed_[i]) + gravity * pos_[1][i];
+        }
+    }
+
+    void Ships::EvaluateScalar(std::size_t first, std::size_t last, const float* polynomials, float gravity)
+    {
+        for (std::size_t i = first; i < last; ++i)
+        {
+            const float* p = polynomials + POLYNOMIAL_SIZE * curve_[i];
+            Vector3f a(p[0], p[1], p[2]), b(p[3], p[4], p[5]), c(p[6], p[7], p[8]), d(p[9], p[10], p[11]);
+            float t = t_[i];
+
+            // as BezierCurve::PointAt and TangentAt
+            Vector3f pos = (((a*t) + b)*t + c)*t + d;
+            Vector3f heading = Normalised(((3.0f * a*t) + (b + b))*t + c);
+
+            for (std::size_t k = 0; k < 3; ++k)
+            {
+                pos_[k][i] = pos[k];
+                heading_[k][i] = heading[k];
+            }
+
+            // by conservation of energy, v^2 = 2*(energy - gh)
+            float vsqr = 2 * (energy_[i] - gravity * pos.y());
+
+            // test for positive square, and limit the minimum speed to 2
+            speed_[i] = (vsqr > 4) ? sqrt(vsqr) : 2;
+        }
+    }
+
+#ifdef MATHS_SIMD_X86
+    void Ships::ComputeEnergySSE(std::size_t first, float gravity)
+    {
+        __m128 v = _mm_loadu_ps(&speed_[first]);
+        __m128 y = _mm_loadu_ps(&pos_[1][first]);
+
+        __m128 kinetic = _mm_mul_ps(_mm_set1_ps(0.5f), _mm_mul_ps(v, v));
+        _mm_storeu_ps(&energy_[first], _mm_add_ps(kinetic, _mm_mul_ps(_mm_set1_ps(gravity), y)));
+    }
+
+    void Ships::EvaluateSSE(std::size_t first, const float* polynomials, float gravity)
+    {
+        // gather the polynomials of four curves and transpose them so each register
+        // holds one coefficient component for all four ships
+        __m128 coef[POLYNOMIAL_SIZE];
+        for (std::size_t q = 0; q < POLYNOMIAL_SIZE; q += 4)
+        {
+            for (std::size_t l = 0; l < 4; ++l) {
+                coef[q + l] = _mm_loadu_ps(polynomials + POLYNOMIAL_SIZE * curve_[first + l] + q);
+            }
+            _MM_TRANSPOSE4_PS(coef[q], coef[q + 1], coef[q + 2], coef[q + 3]);
+        }
+        const __m128* a = coef, *b = coef + 3, *c = coef + 6, *d = coef + 9;
+
+        __m128 t = _mm_loadu_ps(&t_[first]);
+        __m128 three = _mm_set1_ps(3.0f);
+        __m128 pos[3], tangent[3];
+
+        for (std::size_t k = 0; k < 3; ++k)
+        {
+            pos[k] = _mm_add_ps(_mm_mul_ps(a[k], t), b[k]);
+            pos[k] = _mm_add_ps(_mm_mul_ps(pos[k], t), c[k]);
+            pos[k] = _mm_add_ps(_mm_mul_ps(pos[k], t), d[k]);
+
+            tangent[k] = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(a[k], three), t), _mm_add_ps(b[k], b[k]));
+            tangent[k] = _mm_add_ps(_mm_mul_ps(tangent[k], t), c[k]);
+        }
+
+        // normalise by multiplying with the reciprocal magnitude, leaving null tangents alone
+        __m128 magSqr = _mm_add_ps(_mm_add_ps(_mm_mul_ps(tangent[0], tangent[0]),
+            _mm_mul_ps(tangent[1], tangent[1])), _mm_mul_ps(tangent[2], tangent[2]));
+        __m128 inv = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(magSqr));
+        __m128 zero = _mm_and_ps(_mm_and_ps(_mm_cmpeq_ps(tangent[0], _mm_setzero_ps()),
+            _mm_cmpeq_ps(tangent[1], _mm_setzero_ps())), _mm_cmpeq_ps(tangent[2], _mm_setzero_ps()));
+
+        for (std::size_t k = 0; k < 3; ++k)
+        {
+            __m128 unit = _mm_mul_ps(tangent[k], inv);
+            _mm_storeu_ps(&pos_[k][first], pos[k]);
+            _mm_storeu_ps(&heading_[k][first], _mm_or_ps(_mm_and_ps(zero, tangent[k]), _mm_andnot_ps(zero, unit)));
+        }
+
+        // v^2 = 2*(energy - gh), with the speed limited to 2 from below
+        __m128 energy = _mm_loadu_ps(&energy_[first]);
+        __m128 vsqr = _mm_mul_ps(_mm_set1_ps(2.0f), _mm_sub_ps(energy, _mm_mul_ps(_mm_set1_ps(gravity), pos[1])));
+        __m128 fast = _mm_cmpgt_ps(vsqr, _mm_set1_ps(4.0f));
+
+        _mm_storeu_ps(&speed_[first], _mm_or_ps(_mm_and_ps(fast, _mm_sqrt_ps(vsqr)),
+            _mm_andnot_ps(fast, _mm_set1_ps(2.0f))));
+    }
+#endif
+}
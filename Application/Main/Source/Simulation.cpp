@@ -0,0 +1,103 @@
+/*!
+    @file Simulation.cpp @author Joel Barrett @date 16/10/26 @brief Fixed-timestep simulation of a track on its own thread.
+*/
+
+#include "Simulation.h"
+
+namespace Application
+{
+    Simulation::ShipState Simulation::Frame::Interpolate(std::size_t i, float alpha) const
+    {
+        assert(i < current.size());
+
+        // a ship added since the step before has nowhere to come from
+        if (i >= previous.size()) {
+            return current[i];
+        }
+        ShipState state;
+        state.pos = previous[i].pos + (current[i].pos - previous[i].pos) * alpha;
+        state.heading = Normalised(previous[i].heading + (current[i].heading - previous[i].heading) * alpha);
+        return state;
+    }
+
+    Simulation::Simulation()
+        : track_(NULL), running_(false), step_(0.0f){}
+
+    Simulation::~Simulation()
+    {
+        Stop();
+    }
+
+    void Simulation::Start(Track &track, float rate)
+    {
+        assert(!thread_.joinable() && rate > 0.0f);
+
+        track_ = &track;
+        step_ = 1.0f / rate;
+        running_ = true;
+        thread_ = std::thread(&Simulation::Run, this);
+    }
+
+    void Simulation::Stop()
+    {
+        running_ = false;
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    const Simulation::Frame& Simulation::AcquireFrame(float &alpha)
+    {
+        frames_.Acquire();
+        const Frame &frame = frames_.Front();
+
+        // the frame is a step behind the present, which falls a fraction of the next step past it
+        float elapsed = std::chrono::duration<float>(Clock::now() - frame.time).count();
+        alpha = step_ > 0.0f ? Clamp(elapsed / step_, 0.0f, 1.0f) : 1.0f;
+        return frame;
+    }
+
+    void Simulation::Run()
+    {
+        Clock::duration step = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(step_));
+        Clock::time_point next = Clock::now();
+
+        while (running_)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                track_->Update(step_);
+                Publish();
+            }
+
+            // steps that fall behind are caught up without sleeping, unless so many
+            // are owed that the time is better dropped
+            next += step;
+            Clock::time_point now = Clock::now();
+            if (now - next > step * MAX_CATCH_UP) {
+                next = now;
+            }
+            std::this_thread::sleep_until(next);
+        }
+    }
+
+    void Simulation::Publish()
+    {
+        Frame &frame = frames_.Back();
+        frame.previous = last_;
+
+        // straight from the ships' arrays, as this holds up anything waiting on the lock
+        const Ships &ships = track_->GetShips();
+        frame.current.resize(ships.size());
+
+        for (std::size_t i = 0; i < frame.current.size(); ++i)
+        {
+            frame.current[i].pos = ships.GetPosition(i);
+            frame.current[i].heading = ships.GetHeading(i);
+        }
+        frame.time = Clock::now();
+        last_ = frame.current;
+
+        frames_.Publish();
+    }
+}
@@ -0,0 +1,257 @@
+/*!
+    @file Tessellator.cpp @author Joel Barrett @date 16/10/26 @brief Batched tessellation of track curves.
+*/
+
+#include "Tessellator.h"
+
+namespace Application
+{
+    namespace
+    {
+        //! lane groups handed to a thread at a time
+        const std::size_t GROUPS_PER_TASK = 16;
+    }
+
+    void Tessellator::Tessellate(std::vector< BezierCurve<> > &curves, std::size_t res, ThreadPool &pool)
+    {
+        if (curves.empty()) {
+            return;
+        }
+        Gather(curves, res);
+
+        // the only table lookup that may build, so it stays outside the parallel section
+        const BasisTable<float> &basis = basis_.Get(res);
+
+        SimdLevel simd = GetSimdLevel();
+        std::size_t width = simd == SIMD_AVX ? 8 : 4;
+        std::size_t groups = (curves.size() + width - 1) / width;
+
+        pool.ParallelFor(groups, GROUPS_PER_TASK, [&](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t g = begin; g < end; ++g)
+            {
+                switch (simd)
+                {
+#ifdef MATHS_SIMD_X86
+                case SIMD_AVX:
+                    TessellateAVX(g * width, basis);
+                    break;
+
+                case SIMD_SSE:
+                    TessellateSSE(g * width, basis);
+                    break;
+#endif
+                default:
+                    TessellateScalar(g * width, Min(g * width + width, out_.size()), basis);
+                    break;
+                }
+            }
+        });
+    }
+
+    void Tessellator::Gather(std::vector< BezierCurve<> > &curves, std::size_t res)
+    {
+        // pad to a whole AVX lane group by repeating the last curve
+        std::size_t padded = (curves.size() + 7) & ~std::size_t(7);
+
+        for (std::size_t p = 0; p < 4; ++p)
+        {
+            for (std::size_t k = 0; k < 3; ++k)
+            {
+                soa_[p][k].resize(padded);
+                for (std::size_t i = 0; i < padded; ++i) {
+                    soa_[p][k][i] = curves[Min(i, curves.size() - 1)].GetCtrlPoint(p)[k];
+                }
+            }
+        }
+        out_.resize(curves.size());
+        for (std::size_t i = 0; i < curves.size(); ++i)
+        {
+            assert(curves[i].GetResolution() == res);
+            out_[i] = &curves[i].GetPolylineStorage(res)->x();
+        }
+    }
+
+    void Tessellator::TessellateScalar(std::size_t first, std::size_t last, const BasisTable<float> &basis)
+    {
+        for (std::size_t i = first; i < last; ++i)
+        {
+            Vector3f p[4];
+            for (std::size_t j = 0; j < 4; ++j) {
+                p[j] = Vector3f(soa_[j][0][i], soa_[j][1][i], soa_[j][2][i]);
+            }
+            basis.Evaluate(p, reinterpret_cast<Vector3f*>(out_[i]));
+        }
+    }
+
+#ifdef MATHS_SIMD_X86
+    namespace
+    {
+        //! interleave four steps of one curve, held as x, y and z registers, into vertices
+        inline void StoreVerts(float* out, __m128 x, __m128 y, __m128 z)
+        {
+            __m128 lo = _mm_unpacklo_ps(x, y); // x0 y0 x1 y1
+            __m128 hi = _mm_unpackhi_ps(x, y); // x2 y2 x3 y3
+            __m128 zx = _mm_shuffle_ps(z, lo, _MM_SHUFFLE(2,2,0,0)); // z0 z0 x1 x1
+            __m128 yz = _mm_shuffle_ps(lo, z, _MM_SHUFFLE(1,1,3,3)); // y1 y1 z1 z1
+            __m128 zz = _mm_shuffle_ps(z, hi, _MM_SHUFFLE(3,2,3,2)); // z2 z3 x3 y3
+
+            _mm_storeu_ps(out, _mm_shuffle_ps(lo, zx, _MM_SHUFFLE(2,0,1,0)));
+            _mm_storeu_ps(out + 4, _mm_shuffle_ps(yz, hi, _MM_SHUFFLE(1,0,2,0)));
+            _mm_storeu_ps(out + 8, _mm_shuffle_ps(zz, zz, _MM_SHUFFLE(1,3,2,0)));
+        }
+
+        //! transpose four steps of four curves so each register holds one curve, then store them
+        inline void StoreBlock(float* const* out, std::size_t lanes, std::size_t offset, __m128* x, __m128* y, __m128* z)
+        {
+            _MM_TRANSPOSE4_PS(x[0], x[1], x[2], x[3]);
+            _MM_TRANSPOSE4_PS(y[0], y[1], y[2], y[3]);
+            _MM_TRANSPOSE4_PS(z[0], z[1], z[2], z[3]);
+
+            for (std::size_t l = 0; l < lanes && l < 4; ++l) {
+                StoreVerts(out[l] + offset, x[l], y[l], z[l]);
+            }
+        }
+
+        //! one sample of each axis, weighted in the same order as BasisTable::Evaluate
+        inline void Evaluate(const float* w, const __m128 (*p)[3], __m128 &x, __m128 &y, __m128 &z)
+        {
+            __m128 w0 = _mm_set1_ps(w[0]), w1 = _mm_set1_ps(w[1]), w2 = _mm_set1_ps(w[2]), w3 = _mm_set1_ps(w[3]);
+            __m128* axes[3] = { &x, &y, &z };
+
+            for (std::size_t k = 0; k < 3; ++k)
+            {
+                __m128 v = _mm_add_ps(_mm_mul_ps(p[0][k], w0), _mm_mul_ps(p[1][k], w1));
+                v = _mm_add_ps(v, _mm_mul_ps(p[2][k], w2));
+                *axes[k] = _mm_add_ps(v, _mm_mul_ps(p[3][k], w3));
+            }
+        }
+
+        MATHS_TARGET_AVX inline void Evaluate(const float* w, const __m256 (*p)[3], __m256 &x, __m256 &y, __m256 &z)
+        {
+            __m256 w0 = _mm256_broadcast_ss(w), w1 = _mm256_broadcast_ss(w + 1);
+            __m256 w2 = _mm256_broadcast_ss(w + 2), w3 = _mm256_broadcast_ss(w + 3);
+            __m256* axes[3] = { &x, &y, &z };
+
+            for (std::size_t k = 0; k < 3; ++k)
+            {
+                __m256 v = _mm256_add_ps(_mm256_mul_ps(p[0][k], w0), _mm256_mul_ps(p[1][k], w1));
+                v = _mm256_add_ps(v, _mm256_mul_ps(p[2][k], w2));
+                *axes[k] = _mm256_add_ps(v, _mm256_mul_ps(p[3][k], w3));
+            }
+        }
+
+        //! the low (half = 0) or high (half = 1) four lanes of four steps
+        MATHS_TARGET_AVX inline void Split(const __m256* x, const __m256* y, const __m256* z, int half, 
+            __m128* hx, __m128* hy, __m128* hz)
+        {
+            for (std::size_t j = 0; j < 4; ++j)
+            {
+                hx[j] = half ? _mm256_extractf128_ps(x[j], 1) : _mm256_castps256_ps128(x[j]);
+                hy[j] = half ? _mm256_extractf128_ps(y[j], 1) : _mm256_castps256_ps128(y[j]);
+                hz[j] = half ? _mm256_extractf128_ps(z[j], 1) : _mm256_castps256_ps128(z[j]);
+            }
+        }
+
+        //! store fewer than four steps of four curves one float at a time
+        inline void StoreTail(float* const* out, std::size_t lanes, std::size_t offset, std::size_t steps, 
+            const __m128* x, const __m128* y, const __m128* z)
+        {
+            float v[3][4];
+            for (std::size_t j = 0; j < steps; ++j)
+            {
+                _mm_storeu_ps(v[0], x[j]);
+                _mm_storeu_ps(v[1], y[j]);
+                _mm_storeu_ps(v[2], z[j]);
+
+                for (std::size_t l = 0; l < lanes && l < 4; ++l)
+                {
+                    float* o = out[l] + offset + 3 * j;
+                    o[0] = v[0][l]; o[1] = v[1][l]; o[2] = v[2][l];
+                }
+            }
+        }
+    }
+
+    void Tessellator::TessellateSSE(std::size_t first, const BasisTable<float> &basis)
+    {
+        std::size_t lanes = out_.size() - first, res = basis.GetResolution();
+
+        // the 4 x 3 control point matrix of four curves, one register per entry
+        __m128 p[4][3];
+        for (std::size_t j = 0; j < 4; ++j)
+        {
+            for (std::size_t k = 0; k < 3; ++k) {
+                p[j][k] = _mm_loadu_ps(&soa_[j][k][first]);
+            }
+        }
+        // four samples at a time are kept in registers and transposed on the way out
+        __m128 x[4], y[4], z[4];
+        std::size_t i = 0;
+        for (; i + 4 <= res; i += 4)
+        {
+            for (std::size_t j = 0; j < 4; ++j) {
+                Evaluate(basis.GetRow(i + j), p, x[j], y[j], z[j]);
+            }
+            StoreBlock(&out_[first], lanes, 3 * i, x, y, z);
+        }
+        for (std::size_t j = 0; i + j < res; ++j) {
+            Evaluate(basis.GetRow(i + j), p, x[j], y[j], z[j]);
+        }
+        StoreTail(&out_[first], lanes, 3 * i, res - i, x, y, z);
+    }
+
+    MATHS_TARGET_AVX void Tessellator::TessellateAVX(std::size_t first, const BasisTable<float> &basis)
+    {
+        std::size_t lanes = out_.size() - first, res = basis.GetResolution();
+
+        // the 4 x 3 control point matrix of eight curves, one register per entry
+        __m256 p[4][3];
+        for (std::size_t j = 0; j < 4; ++j)
+        {
+            for (std::size_t k = 0; k < 3; ++k) {
+                p[j][k] = _mm256_loadu_ps(&soa_[j][k][first]);
+            }
+        }
+        // four samples at a time, each half of the registers transposed like the SSE path
+        __m256 x[4], y[4], z[4];
+        __m128 hx[4], hy[4], hz[4];
+        std::size_t i = 0;
+        for (; i + 4 <= res; i += 4)
+        {
+            for (std::size_t j = 0; j < 4; ++j) {
+                Evaluate(basis.GetRow(i + j), p, x[j], y[j], z[j]);
+            }
+            Split(x, y, z, 0, hx, hy, hz);
+            StoreBlock(&out_[first], lanes, 3 * i, hx, hy, hz);
+
+            if (lanes > 4)
+            {
+                Split(x, y, z, 1, hx, hy, hz);
+                StoreBlock(&out_[first + 4], lanes - 4, 3 * i, hx, hy, hz);
+            }
+        }
+        for (std::size_t j = 0; i + j < res; ++j) {
+            Evaluate(basis.GetRow(i + j), p, x[j], y[j], z[j]);
+        }
+        Split(x, y, z, 0, hx, hy, hz);
+        StoreTail(&out_[first], lanes, 3 * i, res - i, hx, hy, hz);
+
+        if (lanes > 4)
+        {
+            Split(x, y, z, 1, hx, hy, hz);
+            StoreTail(&out_[first + 4], lanes - 4, 3 * i, res - i, hx, hy, hz);
+        }
+    }
+#else
+    void Tessellator::TessellateSSE(std::size_t first, const BasisTable<float> &basis)
+    {
+        TessellateScalar(first, Min(first + 4, out_.size()), basis);
+    }
+
+    void Tessellator::TessellateAVX(std::size_t first, const BasisTable<float> &basis)
+    {
+        TessellateScalar(first, Min(first + 8, out_.size()), basis);
+    }
+#endif
+}
@@ -6,7 +6,9 @@
 
 namespace Application
 {
-    Track::Track(): length_(0.0f), resolution_(75), ctrlPointRadius_(0.24f), ctrlPointSelected_(false)
+    Track::Track(std::size_t threads): first_(0), unusedVertices_(0), layoutVersion_(0), bvhBuilt_(false), 
+        threadPool_(threads), resolution_(75), ctrlPointRadius_(0.24f), ctrlPointSelected_(false), 
+        tessellationMode_(BezierCurve<>::TESSELLATE_UNIFORM), chordTolerance_(0.01f)
     {
         curves_.reserve(4);
     }
@@ -15,8 +17,12 @@ namespace Application
     {
         assert(curves_.empty());
 
-        curves_.push_back(BezierCurve<>(a, b, c, d, resolution_));
-        length_ += curves_.back().GetLength();
+        BezierCurve<> curve(a, b, c, d, resolution_, false);
+        ApplyTessellationMode(curve);
+
+        std::size_t i = LinkCurve(curve, first_);
+        UpdateRange(i);
+        InsertIntoBVH(i);
     }
 
     void Track::AddCurveToEnd(const Vector3f &c, const Vector3f &d)
@@ -24,10 +30,15 @@ namespace Application
         assert(!curves_.empty());
 
         // compute 2nd control point whilst maintaining C1 continuity
-        Vector3f b = curves_.back().GetCtrlPoint(3) + curves_.back().GetCtrlPoint(3) - curves_.back().GetCtrlPoint(2);
+        const BezierCurve<> &last = curves_[prev_[first_]];
+        Vector3f b = last.GetCtrlPoint(3) + last.GetCtrlPoint(3) - last.GetCtrlPoint(2);
+
+        BezierCurve<> curve(last.GetCtrlPoint(3), b, c, d, resolution_, false);
+        ApplyTessellationMode(curve);
 
-        curves_.push_back(BezierCurve<>(curves_.back().GetCtrlPoint(3), b, c, d, resolution_));
-        length_ += curves_.back().GetLength();
+        std::size_t i = LinkCurve(curve, first_);
+        UpdateRange(i);
+        InsertIntoBVH(i);
     }
 
     void Track::AddLastCurve()
@@ -35,68 +46,359 @@ namespace Application
         assert(!curves_.empty());
 
         // compute 2nd and 3rd control points whilst maintaining C1 continuity
-        Vector3f b = curves_.back().GetCtrlPoint(3) + curves_.back().GetCtrlPoint(3) - curves_.back().GetCtrlPoint(2);
-        Vector3f c = curves_.front().GetCtrlPoint(0) + curves_.front().GetCtrlPoint(0) - curves_.front().GetCtrlPoint(1);
+        const BezierCurve<> &last = curves_[prev_[first_]], &first = curves_[first_];
+        Vector3f b = last.GetCtrlPoint(3) + last.GetCtrlPoint(3) - last.GetCtrlPoint(2);
+        Vector3f c = first.GetCtrlPoint(0) + first.GetCtrlPoint(0) - first.GetCtrlPoint(1);
+
+        BezierCurve<> curve(last.GetCtrlPoint(3), b, c, first.GetCtrlPoint(0), resolution_, false);
+        ApplyTessellationMode(curve);
 
-        curves_.push_back(BezierCurve<>(curves_.back().GetCtrlPoint(3), b, c, curves_.front().GetCtrlPoint(0), resolution_));
-        length_ += curves_.back().GetLength();
+        std::size_t i = LinkCurve(curve, first_);
+        UpdateRange(i);
+        InsertIntoBVH(i);
     }
 
     void Track::AddCurve()
     {
         assert(!curves_.empty());
         
-        // iterate through list to find curve with greatest arc length
-        std::size_t i = 1, longestCurveIndex = 0;
-        std::vector< BezierCurve<> >::iterator longestCurve = curves_.begin();
-        for (std::vector< BezierCurve<> >::iterator it = ++curves_.begin(); it != curves_.end(); ++it, ++i)
+        // the longest curve is kept on top of the heap of arc lengths
+        std::size_t longestCurve = curveLengths_.top();
+
+        // roughly bisect the longest curve using de Casteljau's method, keeping the 
+        // right half in place and linking the left half in before it
+        Vector3f left[4], right[4];
+
+        curves_[longestCurve].Split(0.5f, left, right);
+        curves_[longestCurve].SetCtrlPoints(right[0], right[1], right[2], right[3]);
+        curves_[longestCurve].ComputeCoefficients();
+        curves_[longestCurve].ComputePolyline();
+        UpdateRange(longestCurve);
+        StorePolynomial(longestCurve);
+        curveLengths_.update(longestCurve, curves_[longestCurve].GetLength());
+        distances_.update(longestCurve, curves_[longestCurve].GetTableLength());
+
+        BezierCurve<> leftCurve(left[0], left[1], left[2], left[3], resolution_, false);
+        ApplyTessellationMode(leftCurve);
+        leftCurve.ComputePolyline();
+
+        std::size_t leftIndex = LinkCurve(leftCurve, longestCurve, longestCurve == first_);
+        UpdateRange(leftIndex);
+
+        // maintain the current position of any ships on the split curve, walking its list 
+        // backwards as ships moving to the new curve are swapped out with the last entry
+        std::vector< std::size_t > &ships = shipsByCurve_[longestCurve];
+        for (std::size_t j = ships.size(); j-- > 0; )
         {
-            if (it->GetLength() > longestCurve->GetLength())
-            {
-                longestCurve = it;
-                longestCurveIndex = i;
+            float t = ships_.GetT(ships[j]);
+            if (t < 0.5f) {
+                ships_.SetT(ships[j], t * 2.0f);
+                MoveShip(ships[j], longestCurve, leftIndex);
+            }
+            else {
+                ships_.SetT(ships[j], (t - 0.5f) * 2.0f); 
+            }
+        }
+
+        if (bvhBuilt_) {
+            bvh_.Insert(curves_, leftIndex, longestCurve);
+        }
+    }
+
+    std::size_t Track::LinkCurve(BezierCurve<> &curve, std::size_t next, bool first)
+    {
+        // the curve's polyline is still owned, so moving it into its slot copies no vertices
+        std::size_t i = curves_.size();
+        curves_.push_back(std::move(curve));
+        ranges_.push_back(Range());
+        curveVersions_.push_back(0);
+        shipsByCurve_.push_back(std::vector< std::size_t >());
+        polynomials_.resize(polynomials_.size() + Ships::POLYNOMIAL_SIZE);
+        StorePolynomial(i);
+        curveLengths_.push(i, curves_[i].GetLength());
+
+        // linking in before the first curve otherwise closes the circuit, at the end of the track
+        distances_.insert(i, curves_[i].GetTableLength(), 
+            first || next != first_ ? next : PrefixSumTree<float>::NPOS);
+
+        if (i == 0)
+        {
+            next_.push_back(i);
+            prev_.push_back(i);
+            first_ = i;
+        }
+        else
+        {
+            next_.push_back(next);
+            prev_.push_back(prev_[next]);
+            next_[prev_[next]] = i;
+            prev_[next] = i;
+
+            if (first) {
+                first_ = i;
             }
         }
-        // maintain the current position of any ships affected
-        for (std::vector< Ship >::iterator it = ships_.begin(); it != ships_.end(); ++it)
+        return i;
+    }
+
+    void Track::Tessellate()
+    {
+        // the track is built up a curve at a time before it's first tessellated, so the tree is built 
+        // once over all of them rather than after every curve
+        if (!bvhBuilt_)
+        {
+            bvh_.Build(curves_, ctrlPointRadius_);
+            bvhBuilt_ = true;
+        }
+
+        if (tessellationMode_ == BezierCurve<>::TESSELLATE_UNIFORM)
+        {
+            // every range is known up front, so the curves are tessellated straight into place
+            ReserveRanges(resolution_);
+            tessellator_.Tessellate(curves_, resolution_, threadPool_);
+        }
+        else
         {
-            // if ship is on the curve that will be split
-            if (it->currentCurve == longestCurveIndex)
+            // adaptive polylines vary in length so each curve is subdivided on its own, 
+            // overflowing its old range into storage of its own if need be
+            threadPool_.ParallelFor(curves_.size(), 1, [&](std::size_t begin, std::size_t end)
             {
-                if (it->t < 0.5f) {
-                    it->t *= 2.0f;
-                }
-                else {
-                    it->t = (it->t - 0.5f) * 2.0f; 
-                    it->currentCurve++; 
+                for (std::size_t i = begin; i < end; ++i) {
+                    curves_[i].ComputePolyline();
                 }
+            });
+            PackRanges();
+        }
+    }
+
+    void Track::Recompute(std::size_t i)
+    {
+        curves_[i].ComputeCoefficients();
+        curves_[i].ComputePolyline();
+        UpdateRange(i);
+        StorePolynomial(i);
+        curveLengths_.update(i, curves_[i].GetLength());
+        distances_.update(i, curves_[i].GetTableLength());
+
+        if (bvhBuilt_) {
+            bvh_.Refit(curves_, i);
+        }
+    }
+
+    void Track::AttachRanges()
+    {
+        for (std::size_t i = 0; i < curves_.size(); ++i)
+        {
+            if (ranges_[i].capacity) {
+                curves_[i].AttachPolyline(&vertices_[ranges_[i].offset], ranges_[i].capacity, curves_[i].GetNumPolylineVerts());
             }
-            // if ship is beyond the curve that will be split
-            else if (it->currentCurve > longestCurveIndex) {
-                it->currentCurve++;
+        }
+    }
+
+    void Track::ReserveRanges(std::size_t count)
+    {
+        vertices_.resize(curves_.size() * count);
+        unusedVertices_ = 0;
+        ++layoutVersion_;
+
+        // the polylines are about to be overwritten, so none of the old contents are adopted
+        std::size_t i = first_, offset = 0;
+        do
+        {
+            ranges_[i] = Range(offset, count);
+            curves_[i].AttachPolyline(&vertices_[offset], count);
+
+            offset += count;
+            i = next_[i];
+        } while (i != first_);
+    }
+
+    void Track::PackRanges()
+    {
+        std::vector< Vector3f > packed;
+        unusedVertices_ = 0;
+        ++layoutVersion_;
+
+        std::size_t i = first_;
+        do
+        {
+            ranges_[i] = Range(packed.size(), curves_[i].GetNumPolylineVerts());
+            for (std::size_t j = 0; j < curves_[i].GetNumPolylineVerts(); ++j) {
+                packed.push_back(curves_[i].GetPolylineVert(j));
             }
+            i = next_[i];
+        } while (i != first_);
+
+        vertices_.swap(packed);
+        AttachRanges();
+    }
+
+    void Track::UpdateRange(std::size_t i)
+    {
+        std::size_t count = curves_[i].GetNumPolylineVerts();
+
+        // a polyline that fits its range was written in place
+        if (curves_[i].IsPolylineExternal())
+        {
+            ++curveVersions_[i];
+            return;
         }
 
-        // roughly bisect the longest curve using de Casteljau's method
-        Vector3f left[4], right[4];
+        // otherwise it moves to a new range at the end of the pool, leaving its old one unused 
+        // until there is enough waste to be worth packing the pool back into track order
+        unusedVertices_ += ranges_[i].capacity;
+        if (unusedVertices_ > vertices_.size() / 2)
+        {
+            PackRanges();
+            return;
+        }
 
-        longestCurve->Split(0.5f, left, right);
-        longestCurve->SetCtrlPoints(right[0], right[1], right[2], right[3]);
-        longestCurve->Compute();
+        const Vector3f* pool = GetVertices();
+        ranges_[i] = Range(vertices_.size(), count);
+        vertices_.resize(vertices_.size() + count);
+        ++curveVersions_[i];
+        for (std::size_t j = 0; j < count; ++j) {
+            vertices_[ranges_[i].offset + j] = curves_[i].GetPolylineVert(j);
+        }
 
-        curves_.insert(longestCurve, BezierCurve<>(left[0], left[1], left[2], left[3], resolution_));
+        // the other polylines only have to follow if growing the pool moved it
+        if (GetVertices() != pool) {
+            AttachRanges();
+        }
+        else if (count) {
+            curves_[i].AttachPolyline(&vertices_[ranges_[i].offset], count, count);
+        }
     }
 
-    void Track::AddShip()
+    void Track::InsertIntoBVH(std::size_t i)
     {
-        ships_.push_back(Ship(curves_.front().GetCtrlPoint(0), 
-            curves_.front().TangentAt(0.0f)));
+        // a curve appended to a track already in the tree is paired with the curve before it, which it joins
+        if (bvhBuilt_) {
+            bvh_.Insert(curves_, i, prev_[i]);
+        }
+    }
+
+    void Track::ApplyTessellationMode(BezierCurve<> &curve) const
+    {
+        curve.SetTessellationMode(tessellationMode_, chordTolerance_);
+    }
+
+    Track::Projection Track::ClosestPoint(const Vector3f &p) const
+    {
+        assert(!curves_.empty());
+
+        // only curves whose boxes are closer than the nearest found so far are projected onto
+        Projection nearest;
+        nearest.dist = std::numeric_limits<float>::max();
+
+        bvh_.Nearest(p, [&](std::size_t i) -> float
+        {
+            float dist = 0.0f;
+            float t = curves_[i].ClosestPoint(p, &dist);
+
+            if (dist < nearest.dist)
+            {
+                nearest.curve = i;
+                nearest.t = t;
+                nearest.dist = dist;
+            }
+            return dist;
+        }, nearest.dist);
+
+        return nearest;
+    }
+
+    void Track::ClosestPoints(const Vector3f* points, std::size_t count, Projection* results)
+    {
+        threadPool_.ParallelFor(count, 64, [&](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t i = begin; i < end; ++i) {
+                results[i] = ClosestPoint(points[i]);
+            }
+        });
+    }
+
+    Track::Location Track::Locate(float distance) const
+    {
+        assert(!curves_.empty());
+
+        Location location;
+        float length = distances_.total();
+        if (length <= 0.0f)
+        {
+            // everywhere on a track of no length is its start
+            location.curve = first_;
+            return location;
+        }
+
+        distance = fmod(distance, length);
+        if (distance < 0.0f) {
+            distance += length;
+        }
+
+        float offset = 0.0f;
+        location.curve = distances_.find(distance, offset);
+        location.t = curves_[location.curve].ParamAtDist(offset);
+
+        return location;
+    }
+
+    float Track::DistanceAt(std::size_t curve, float t) const
+    {
+        assert(curve < curves_.size());
+        return distances_.prefix(curve) + curves_[curve].DistAtParam(t);
+    }
+
+    void Track::AddShip(float distance)
+    {
+        Location location = Locate(distance);
+
+        ships_.push_back(curves_[location.curve].PointAt(location.t), 
+            curves_[location.curve].TangentAt(location.t), location.curve, location.t);
+        shipEntries_.push_back(shipsByCurve_[location.curve].size());
+        shipsByCurve_[location.curve].push_back(ships_.size() - 1);
     }
 
     void Track::RemoveShip()
     {
-        if (!ships_.empty()) {
+        if (!ships_.empty())
+        {
+            MoveShip(ships_.size() - 1, ships_.GetCurve(ships_.size() - 1), curves_.size());
             ships_.pop_back();
+            shipEntries_.pop_back();
+        }
+    }
+
+    void Track::StorePolynomial(std::size_t i)
+    {
+        Vector3f coef[4];
+        curves_[i].GetPolynomial(coef[0], coef[1], coef[2], coef[3]);
+
+        float* p = &polynomials_[Ships::POLYNOMIAL_SIZE * i];
+        for (std::size_t j = 0; j < 4; ++j)
+        {
+            for (std::size_t k = 0; k < 3; ++k) {
+                p[3 * j + k] = coef[j][k];
+            }
+        }
+    }
+
+    void Track::MoveShip(std::size_t i, std::size_t from, std::size_t to)
+    {
+        // the last ship in the list takes the place of the one leaving it
+        std::vector< std::size_t > &ships = shipsByCurve_[from];
+        std::size_t entry = shipEntries_[i];
+        assert(ships[entry] == i);
+
+        ships[entry] = ships.back();
+        shipEntries_[ships.back()] = entry;
+        ships.pop_back();
+
+        if (to < curves_.size())
+        {
+            shipEntries_[i] = shipsByCurve_[to].size();
+            shipsByCurve_[to].push_back(i);
+            ships_.SetCurve(i, to);
         }
     }
 
@@ -104,189 +406,200 @@ namespace Application
     {
         static const float gravity = 14.0f;
 
-        for (std::vector< Ship >::iterator it = ships_.begin(); it != ships_.end(); ++it)
-        {
-            // distance = speed * time
-            float distance = it->speed * dt;
+        // each ship only reads the curves and writes its own state, so ranges of ships 
+        // are moved on any thread and the results don't depend on how many there are
+        previousCurves_.resize(ships_.size());
 
+        // a track whose control points have all been dragged together has nowhere to move on to
+        bool moving = distances_.total() > 0.0f;
+        threadPool_.ParallelFor(ships_.size(), SHIPS_PER_TASK, [&](std::size_t begin, std::size_t end)
+        {
             // energy = 1/2*mv^2 + mgh (mass = 1)
-            float energystart = 0.5f * Sqr(it->speed) + gravity * it->pos.y();
+            ships_.ComputeEnergy(gravity, begin, end);
 
-            while (distance > 0.0f)
+            for (std::size_t i = begin; i < end; ++i)
             {
-                it->t += 0.0001f;
+                std::size_t curve = previousCurves_[i] = ships_.GetCurve(i);
+
+                // distance = speed * time
+                float distance = ships_.GetSpeed(i) * dt;
 
-                // if ship has reached end of current curve
-                if (it->t > 1.0f)
+                // distance along the current curve after moving, carried over onto following curves
+                float s = curves_[curve].DistAtParam(ships_.GetT(i)) + distance;
+                while (moving && s > curves_[curve].GetTableLength())
                 {
-                    it->currentCurve++;
-                    it->t = 0.0f;
-
-                    // if ship has reached end of piecewise curve
-                    if (it->currentCurve == curves_.size())
-                    {
-                        it->currentCurve = 0;
-                        distance = 0.0f;
-                    }
-                }
-                Vector3f newpos = curves_[it->currentCurve].PointAt(it->t);
-                distance -= Mag(newpos - it->pos);
+                    s -= curves_[curve].GetTableLength();
 
-                it->pos = newpos;
-                it->heading = curves_[it->currentCurve].TangentAt(it->t);
+                    // the last curve links back round to the first
+                    curve = next_[curve];
+                }
+                ships_.SetCurve(i, curve);
+                ships_.SetT(i, curves_[curve].ParamAtDist(s));
             }
 
-            // by conservation of energy, v^2 = 2*(energy - gh)
-            float vsqr = 2 * (energystart - gravity * it->pos.y());
+            // position, heading and, by conservation of energy, speed at the new parameters
+            ships_.Evaluate(&polynomials_[0], gravity, begin, end);
+        });
 
-            // test for positive square, and limit the minimum speed to 2
-            //if (!constantSpeed)
-            it->speed = (vsqr > 4) ? sqrt(vsqr) : 2;
+        // the lists of ships on each curve are shared, so they are updated afterwards in ship order
+        for (std::size_t i = 0; i < ships_.size(); ++i)
+        {
+            if (ships_.GetCurve(i) != previousCurves_[i]) {
+                MoveShip(i, previousCurves_[i], ships_.GetCurve(i));
+            }
         }
     }
 
     void Track::IncResolution()
     {
-        if (resolution_ < 75)
+        if (tessellationMode_ == BezierCurve<>::TESSELLATE_ADAPTIVE)
         {
-            ++resolution_;
-            for (std::vector< BezierCurve<> >::iterator it = curves_.begin(); it != curves_.end(); ++it)
+            if (chordTolerance_ > 0.001f)
             {
+                chordTolerance_ *= 0.5f;
+                for (std::vector< BezierCurve<> >::iterator it = curves_.begin(); it != curves_.end(); ++it) {
+                    ApplyTessellationMode(*it);
+                }
+                Tessellate();
+            }
+        }
+        else if (resolution_ < MAX_RESOLUTION)
+        {
+            // single steps at low resolutions, then roughly 10% at a time
+            resolution_ = Min(resolution_ + Max<std::size_t>(1, resolution_ / 10), std::size_t(MAX_RESOLUTION));
+            for (std::vector< BezierCurve<> >::iterator it = curves_.begin(); it != curves_.end(); ++it) {
                 it->SetResolution(resolution_);
-                it->Compute();
             }
+            Tessellate();
         }
     }
 
     void Track::DecResolution()
     {
-        if (resolution_ > 2)
+        if (tessellationMode_ == BezierCurve<>::TESSELLATE_ADAPTIVE)
         {
-            --resolution_;
-            for (std::vector< BezierCurve<> >::iterator it = curves_.begin(); it != curves_.end(); ++it)
+            if (chordTolerance_ < 1.0f)
             {
+                chordTolerance_ *= 2.0f;
+                for (std::vector< BezierCurve<> >::iterator it = curves_.begin(); it != curves_.end(); ++it) {
+                    ApplyTessellationMode(*it);
+                }
+                Tessellate();
+            }
+        }
+        else if (resolution_ > 2)
+        {
+            resolution_ -= Max<std::size_t>(1, resolution_ / 11);
+            for (std::vector< BezierCurve<> >::iterator it = curves_.begin(); it != curves_.end(); ++it) {
                 it->SetResolution(resolution_);
-                it->Compute();
             }
+            Tessellate();
         }
     }
 
-    void Track::SelectCtrlPoint(const Camera &cam, unsigned width, unsigned height, int x, int y)
+    void Track::ToggleTessellationMode()
     {
-        static float redValue = 0.0f;
-        glGetIntegerv(GL_VIEWPORT, &viewport_[0]);
-        GLint gl_y = viewport_[3] - y - 1;
+        tessellationMode_ = tessellationMode_ == BezierCurve<>::TESSELLATE_UNIFORM ? 
+            BezierCurve<>::TESSELLATE_ADAPTIVE : BezierCurve<>::TESSELLATE_UNIFORM;
 
-        glReadPixels(x, gl_y, 1, 1, GL_RED, GL_FLOAT, &redValue);
-        glReadPixels(x, gl_y, 1, 1, GL_DEPTH_COMPONENT, GL_FLOAT, &zDistToPixel_);
+        for (std::vector< BezierCurve<> >::iterator it = curves_.begin(); it != curves_.end(); ++it) {
+            ApplyTessellationMode(*it);
+        }
+        Tessellate();
+    }
 
-        if (redValue)
-        {
-            // compute the direction vector of ray in world space
-            Vector3f temp = Normalised(ScreenToViewX<float>((float)x, (float)width, (float)height) * -cam.GetRight() + 
-                                       ScreenToViewY<float>((float)y, (float)width, (float)height) * cam.GetDown() - cam.GetForward());
+    void Track::SelectCtrlPoint(Ray<3> ray)
+    {
+        float dmax = 1000.0f;
 
-            Ray<3> ray(cam.GetPosition(), temp);
-            float dmax = 1000.0f;
+        // only the curves whose boxes the ray passes through can own a hit control point
+        std::vector<std::size_t> hits;
+        bvh_.IntersectRay(ray, hits);
 
-            for (std::size_t i = 0; i < curves_.size(); ++i)
+        for (std::vector<std::size_t>::const_iterator it = hits.begin(); it != hits.end(); ++it)
+        {
+            std::size_t i = *it;
+            for (std::size_t j = 0; j < 3; ++j)
             {
-                for (std::size_t j = 0; j < 3; ++j)
+                // test for a collision between ray and a control point sphere
+                if (ray.TestSphere(curves_[i].GetCtrlPoint(j), ctrlPointRadius_) && ray.m_Depth < dmax)
                 {
-                    // test for a collision between ray and a control point sphere
-                    if (ray.TestSphere(curves_[i].GetCtrlPoint(j), ctrlPointRadius_) && ray.m_Depth < dmax)
-                    {
-                        // pick the control point closest to viewer if there's multiple hits
-                        dmax = ray.m_Depth;
-
-                        ctrlPointSelected_ = true;
-                        selectedCurve_ = i;
-                        selectedCtrlPoint_ = j;
-                    }
+                    // pick the control point closest to viewer if there's multiple hits
+                    dmax = ray.m_Depth;
+
+                    ctrlPointSelected_ = true;
+                    selectedCurve_ = i;
+                    selectedCtrlPoint_ = j;
                 }
             }
         }
     }
 
-    void Track::DragCtrlPoint(int x, int y)
+    void Track::DragCtrlPoint(const Vector3d &move)
     {
-        // if camera isn't too close to the sphere
-        if (zDistToPixel_ > 0.8f)
-        {
-            static Vector3f dir;
-            static Vector3d move;
-            static Matrix4x4d view, proj;
-            static float dist = 0.0f;
+        static Vector3f dir;
+        static float dist = 0.0f;
 
-            // get view matrix and projection matrix
-            glGetDoublev(GL_MODELVIEW_MATRIX, &view[0][0]);
-            glGetDoublev(GL_PROJECTION_MATRIX, &proj[0][0]);
-
-            // transform mouse coordinates into world space
-            gluUnProject(x, viewport_[3] - y - 1, zDistToPixel_, &view[0][0], &proj[0][0], 
-                &viewport_[0], &move.x(), &move.y(), &move.z());
+        switch (selectedCtrlPoint_)
+        {
+        case 0: // 1st CP
 
-            switch (selectedCtrlPoint_)
+            if (Dist(move, curves_[prev_[selectedCurve_]].GetCtrlPoint(0)) < 50.0f)
             {
-            case 0: // 1st CP
-
-                if (Dist(move, curves_[selectedCurve_ != 0 ? selectedCurve_ - 1 : GetNumCurves() - 1].GetCtrlPoint(0)) < 50.0f)
-                {
-                    // determine the other curve affected
-                    affectedCurve_ = selectedCurve_ != 0 ? selectedCurve_ - 1 : GetNumCurves() - 1;
-
-                    // compute the distance and direction to move the affected CPs
-                    dist = Dist(curves_[selectedCurve_].GetCtrlPoint(0), curves_[selectedCurve_].GetCtrlPoint(1));
-                    dir = Normalised(curves_[selectedCurve_].GetCtrlPoint(0) - curves_[selectedCurve_].GetCtrlPoint(1));
-
-                    // move the selected and left control point
-                    curves_[selectedCurve_].SetCtrlPoint(0, move);
-                    curves_[selectedCurve_].SetCtrlPoint(1, curves_[selectedCurve_].GetCtrlPoint(0) - dir * dist);
-                    curves_[selectedCurve_].Compute();
-
-                    // move the selected and right control point
-                    curves_[affectedCurve_].SetCtrlPoint(3, move);
-                    curves_[affectedCurve_].SetCtrlPoint(2, curves_[selectedCurve_].GetCtrlPoint(0) + dir * dist);
-                    curves_[affectedCurve_].Compute();
-                }
-                break;
+                // determine the other curve affected
+                affectedCurve_ = prev_[selectedCurve_];
+
+                // compute the distance and direction to move the affected CPs
+                dist = Dist(curves_[selectedCurve_].GetCtrlPoint(0), curves_[selectedCurve_].GetCtrlPoint(1));
+                dir = Normalised(curves_[selectedCurve_].GetCtrlPoint(0) - curves_[selectedCurve_].GetCtrlPoint(1));
+
+                // move the selected and left control point
+                curves_[selectedCurve_].SetCtrlPoint(0, move);
+                curves_[selectedCurve_].SetCtrlPoint(1, curves_[selectedCurve_].GetCtrlPoint(0) - dir * dist);
+                Recompute(selectedCurve_);
+
+                // move the selected and right control point
+                curves_[affectedCurve_].SetCtrlPoint(3, move);
+                curves_[affectedCurve_].SetCtrlPoint(2, curves_[selectedCurve_].GetCtrlPoint(0) + dir * dist);
+                Recompute(affectedCurve_);
+            }
+            break;
 
-            case 1: // 2nd CP
+        case 1: // 2nd CP
 
-                if (Dist(move, curves_[selectedCurve_].GetCtrlPoint(0)) < 25.0f)
-                {
-                    // determine the other affected curve and move the selected CP
-                    affectedCurve_ = selectedCurve_ != 0 ? selectedCurve_ - 1 : GetNumCurves() - 1;
-                    curves_[selectedCurve_].SetCtrlPoint(1, move);
+            if (Dist(move, curves_[selectedCurve_].GetCtrlPoint(0)) < 25.0f)
+            {
+                // determine the other affected curve and move the selected CP
+                affectedCurve_ = prev_[selectedCurve_];
+                curves_[selectedCurve_].SetCtrlPoint(1, move);
 
-                    // compute the distance and direction to move the affected CP
-                    dist = Dist(curves_[selectedCurve_].GetCtrlPoint(0), curves_[selectedCurve_].GetCtrlPoint(1));
-                    dir = Normalised(curves_[selectedCurve_].GetCtrlPoint(0) - curves_[selectedCurve_].GetCtrlPoint(1));
+                // compute the distance and direction to move the affected CP
+                dist = Dist(curves_[selectedCurve_].GetCtrlPoint(0), curves_[selectedCurve_].GetCtrlPoint(1));
+                dir = Normalised(curves_[selectedCurve_].GetCtrlPoint(0) - curves_[selectedCurve_].GetCtrlPoint(1));
 
-                    // move the right control point and recompute affected curves
-                    curves_[affectedCurve_].SetCtrlPoint(2, curves_[selectedCurve_].GetCtrlPoint(0) + dir * dist);
-                    curves_[affectedCurve_].Compute(); curves_[selectedCurve_].Compute();
-                }
-                break;
+                // move the right control point and recompute affected curves
+                curves_[affectedCurve_].SetCtrlPoint(2, curves_[selectedCurve_].GetCtrlPoint(0) + dir * dist);
+                Recompute(affectedCurve_); Recompute(selectedCurve_);
+            }
+            break;
 
-            case 2: // 3rd CP
+        case 2: // 3rd CP
 
-                if (Dist(move, curves_[selectedCurve_].GetCtrlPoint(3)) < 25.0f)
-                {
-                    // determine the other affected curve and move the selected CP
-                    affectedCurve_ = selectedCurve_ != GetNumCurves() - 1 ? selectedCurve_ + 1 : 0;
-                    curves_[selectedCurve_].SetCtrlPoint(2, move);
+            if (Dist(move, curves_[selectedCurve_].GetCtrlPoint(3)) < 25.0f)
+            {
+                // determine the other affected curve and move the selected CP
+                affectedCurve_ = next_[selectedCurve_];
+                curves_[selectedCurve_].SetCtrlPoint(2, move);
 
-                    // compute the distance and direction to move the affected CP
-                    dist = Dist(curves_[selectedCurve_].GetCtrlPoint(3), curves_[selectedCurve_].GetCtrlPoint(2));
-                    dir = Normalised(curves_[selectedCurve_].GetCtrlPoint(3) - curves_[selectedCurve_].GetCtrlPoint(2));
+                // compute the distance and direction to move the affected CP
+                dist = Dist(curves_[selectedCurve_].GetCtrlPoint(3), curves_[selectedCurve_].GetCtrlPoint(2));
+                dir = Normalised(curves_[selectedCurve_].GetCtrlPoint(3) - curves_[selectedCurve_].GetCtrlPoint(2));
 
-                    // move the left control point and recompute affected curves
-                    curves_[affectedCurve_].SetCtrlPoint(1, curves_[selectedCurve_].GetCtrlPoint(3) + dir * dist);
-                    curves_[affectedCurve_].Compute(); curves_[selectedCurve_].Compute();
-                }
-                break;
+                // move the left control point and recompute affected curves
+                curves_[affectedCurve_].SetCtrlPoint(1, curves_[selectedCurve_].GetCtrlPoint(3) + dir * dist);
+                Recompute(affectedCurve_); Recompute(selectedCurve_);
             }
+            break;
         }
     }
 }
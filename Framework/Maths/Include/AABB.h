@@ -0,0 +1,57 @@
+/*!
+    @file AABB.h @author Joel Barrett @date 16/10/26 @brief A generic axis-aligned bounding box.
+*/
+
+#ifndef FRAMEWORK_MATHS_AABB_H
+#define FRAMEWORK_MATHS_AABB_H
+
+#if _MSC_VER > 1000
+    #pragma once
+#endif
+
+#include <limits>
+#include "Vector.h"
+
+namespace Framework
+{
+    namespace Maths
+    {
+        /*!
+            A class for axis-aligned bounding boxes in 2 or 3-dimensional space. A 
+            default constructed box is empty and grows to fit whatever it is extended by.
+        */
+        template < std::size_t N = 3, typename T = float >
+        class AABB
+        {
+        public:
+            AABB();
+            AABB(const Vector<N,T> &min, const Vector<N,T> &max);
+            
+            const Vector<N,T>& GetMin() const { return min_; }
+            const Vector<N,T>& GetMax() const { return max_; }
+            
+            Vector<N,T> GetCentre() const { return (min_ + max_) * 0.5f; }
+            Vector<N,T> GetExtent() const { return max_ - min_; }
+            
+            bool IsEmpty() const { return min_[0] > max_[0]; }
+            
+            // grow the box to enclose a point, a sphere or another box
+            void Extend(const Vector<N,T> &v);
+            void Extend(const Vector<N,T> &centre, T radius);
+            void Extend(const AABB &b);
+            
+            bool Contains(const Vector<N,T> &v) const;
+            bool Overlaps(const AABB &b) const;
+            
+            //! squared distance from a point to the box, zero inside it
+            T DistSqr(const Vector<N,T> &v) const;
+            
+        private:
+            Vector<N,T> min_, max_;
+        };
+    }
+}
+
+#include "../Source/AABB.inl"
+
+#endif // FRAMEWORK_MATHS_AABB_H
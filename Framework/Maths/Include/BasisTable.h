@@ -0,0 +1,65 @@
+/*!
+    @file BasisTable.h @author Joel Barrett @date 16/10/26 @brief Cubic Bernstein basis tables shared between curves.
+*/
+
+#ifndef FRAMEWORK_MATHS_BASISTABLE_H
+#define FRAMEWORK_MATHS_BASISTABLE_H
+
+#if _MSC_VER > 1000
+    #pragma once
+#endif
+
+#include <vector>
+#include "Vector.h"
+
+namespace Framework
+{
+    namespace Maths
+    {
+        /*!
+            The four cubic Bernstein polynomials sampled at t = i / res for i < res, 
+            stored as a res x 4 row-major matrix. Multiplying it by the 4 x N matrix 
+            of a curve's control points gives the curve's uniform polyline, so one 
+            table serves every curve of the same resolution.
+        */
+        template < typename T = float >
+        class BasisTable
+        {
+        public:
+            explicit BasisTable(std::size_t res = 1);
+            
+            std::size_t GetResolution() const { return resolution_; }
+            
+            //! the four weights of sample i
+            const T* GetRow(std::size_t i) const { return &weights_[4 * i]; }
+            
+            //! write the res polyline vertices of the curve with control points p into out
+            template < std::size_t N >
+            void Evaluate(const Vector<N,T>* p, Vector<N,T>* out) const;
+            
+        private:
+            std::size_t resolution_;
+            std::vector<T> weights_;
+        };
+        
+        /*!
+            The basis table for the resolution last asked for, rebuilt when another 
+            is asked for, so that stepping through resolutions holds only one table. 
+            Lookups that may rebuild the table must not run concurrently.
+        */
+        template < typename T = float >
+        class BasisCache
+        {
+        public:
+            //! the table for res, valid until a table for another resolution is asked for
+            const BasisTable<T>& Get(std::size_t res);
+            
+        private:
+            BasisTable<T> table_;
+        };
+    }
+}
+
+#include "../Source/BasisTable.inl"
+
+#endif // FRAMEWORK_MATHS_BASISTABLE_H
@@ -0,0 +1,104 @@
+/*!
+    @file Bezier.h @author Joel Barrett @date 16/10/26 @brief A bezier curve of any degree fixed at compile-time.
+*/
+
+#ifndef FRAMEWORK_MATHS_BEZIER_H
+#define FRAMEWORK_MATHS_BEZIER_H
+
+#if _MSC_VER > 1000
+    #pragma once
+#endif
+
+#include "Curve.h"
+
+namespace Framework
+{
+    namespace Maths
+    {
+        //! binomial coefficient n choose k, folded to a constant wherever n and k are
+        inline constexpr std::size_t Binomial(std::size_t n, std::size_t k)
+        {
+            return k > n ? 0 : (k == 0 || k == n ? 1 : Binomial(n - 1, k - 1) + Binomial(n - 1, k));
+        }
+        
+        //! k-th forward difference of t^n at t = 0 for a unit step, that is k! S(n,k) with S a Stirling number of the 2nd kind
+        inline constexpr std::size_t PowerDifference(std::size_t n, std::size_t k)
+        {
+            return k > n ? 0 : (n == 0 ? 1 : (k == 0 ? 0 : k * (PowerDifference(n - 1, k) + PowerDifference(n - 1, k - 1))));
+        }
+        
+        /*!
+            A class for bezier curves of degree Degree in 2 or 3-dimensional space. 
+            The Bernstein to monomial conversion, the de Casteljau pyramid and the 
+            order of the forward differences all depend only on Degree, so every loop 
+            has a compile-time trip count and the binomials are constants. 
+            
+            BezierCurve remains the cubic used by the track, with arc-length tables, 
+            SIMD tessellation and bounds on top; this family covers the other degrees.
+        */
+        template < std::size_t Degree, std::size_t N = 3, typename T = float >
+        class Bezier : public Curve < N,T,Degree + 1 >
+        {
+            static_assert(Degree >= 1, "a bezier curve needs at least two control points");
+            
+        public:
+            //! number of control points
+            static const std::size_t ORDER = Degree + 1;
+            
+            //! intermediate points in the de Casteljau pyramid, excluding the control points
+            static const std::size_t PYRAMID_SIZE = Degree * (Degree + 1) / 2;
+            
+        public:
+            Bezier();
+            Bezier(const Vector<N,T>* points, std::size_t res = 75);
+            
+            //! copy ORDER control points
+            void SetCtrlPoints(const Vector<N,T>* points);
+            
+            void SetResolution(std::size_t res);
+            
+            void Compute();
+            
+            //! recursive subdivision, writing the pyramid row by row into v[PYRAMID_SIZE]
+            void deCasteljau(T t, Vector<N,T>* v) const;
+            
+            //! split the curve using de Casteljau's method into ORDER points either side
+            void Split(T t, Vector<N,T>* left, Vector<N,T>* right) const;
+            
+            //! find a point on curve using Horner's scheme
+            Vector<N,T> PointAt(T t) const;
+            
+            //! find tangent at point by differentation
+            Vector<N,T> TangentAt(T t) const;
+            
+            //! coefficient of t^i in the monomial form
+            const Vector<N,T>& GetCoefficient(std::size_t i) const { return coeffs_[i]; }
+            
+        protected:
+            // members of the dependent base class, which standard name lookup doesn't search
+            using Curve<N,T,Degree + 1>::ctrlPoints_;
+            using Curve<N,T,Degree + 1>::polylineVerts_;
+            using Curve<N,T,Degree + 1>::degree_;
+            using Curve<N,T,Degree + 1>::resolution_;
+            
+        private:
+            //! convert the control points to the monomial basis
+            void ComputeCoefficients();
+            
+        private:
+            // polynomial coefficients, lowest power first
+            Vector<N,T> coeffs_[ORDER];
+            
+            // stride
+            T h1_;
+        };
+        
+        // the degrees with a name
+        template < std::size_t N = 3, typename T = float > using QuadraticBezier = Bezier<2,N,T>;
+        template < std::size_t N = 3, typename T = float > using QuinticBezier = Bezier<5,N,T>;
+    }
+}
+
+#include "../Source/Bezier.inl"
+
+#endif // FRAMEWORK_MATHS_BEZIER_H
@@ -14,8 +14,8 @@ namespace Framework
     namespace Maths
     {
         /*!
-            A struct of common mathematical constants. Template specialisation is 
-            employed to allow float or double precision.
+            A struct of common mathematical constants, with values given to float 
+            or double precision.
         */
         template < typename T = float >
         struct Const
@@ -38,6 +38,6 @@ namespace Framework
     }
 }
 
-#include "..\source\Constants.inl"
+#include "../Source/Constants.inl"
 
 #endif // CONSTANTS_H_
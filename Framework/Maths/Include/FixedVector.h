@@ -0,0 +1,63 @@
+/*!
+    @file FixedVector.h @author Joel Barrett @date 16/10/26 @brief A vector with inline fixed-capacity storage.
+*/
+
+#ifndef FRAMEWORK_MATHS_FIXEDVECTOR_H
+#define FRAMEWORK_MATHS_FIXEDVECTOR_H
+
+#if _MSC_VER > 1000
+    #pragma once
+#endif
+
+#include <cassert>
+#include <cstddef>
+
+namespace Framework
+{
+    namespace Maths
+    {
+        /*!
+            A sequence of up to Capacity elements held inside the object itself, so 
+            creating, copying and refilling one never touches the heap. Member names 
+            follow std::vector, whose place it takes for small bounded sequences.
+        */
+        template < typename T, std::size_t Capacity >
+        class FixedVector
+        {
+        public:
+            FixedVector(): size_(0){}
+            
+            std::size_t size() const { return size_; }
+            std::size_t capacity() const { return Capacity; }
+            bool empty() const { return size_ == 0; }
+            
+            void clear() { size_ = 0; }
+            void resize(std::size_t n) { assert(n <= Capacity); size_ = n; }
+            void reserve(std::size_t n) { assert(n <= Capacity); (void)n; }
+            
+            void push_back(const T &v) { assert(size_ < Capacity); elems_[size_++] = v; }
+            
+            void assign(const T* first, const T* last)
+            {
+                resize(last - first);
+                for (std::size_t i = 0; i < size_; ++i) {
+                    elems_[i] = first[i];
+                }
+            }
+            
+            const T& operator[] (std::size_t i) const { assert(i < size_); return elems_[i]; }
+            T& operator[] (std::size_t i) { assert(i < size_); return elems_[i]; }
+            
+            const T* begin() const { return elems_; }
+            const T* end() const { return elems_ + size_; }
+            T* begin() { return elems_; }
+            T* end() { return elems_ + size_; }
+            
+        private:
+            T elems_[Capacity];
+            std::size_t size_;
+        };
+    }
+}
+
+#endif // FRAMEWORK_MATHS_FIXEDVECTOR_H
@@ -136,18 +136,32 @@ namespace Framework
         
         //! test for approx. equality to zero with an absolute or relative tolerance
         template < typename T >
-        inline bool IsZero(const T& x, const T& err = Max(1.0f, Abs(x)))
+        inline bool IsZero(const T& x, const T& err)
         {
             return Abs(x) <= (Const<T>::EPSILON * err);
         }
         
+        //! test for approx. equality to zero, relative to x where it exceeds 1
+        template < typename T >
+        inline bool IsZero(const T& x)
+        {
+            return IsZero(x, Max(T(1), Abs(x)));
+        }
+        
         //! test for approx. equality with an absolute or relative tolerance
         template < typename T >
-        inline bool IsEqual(const T& x, const T& y, const T& err = Max(1.0f, Abs(x), Abs(y)))
+        inline bool IsEqual(const T& x, const T& y, const T& err)
         {
             return Abs(x-y) <= (Const<T>::EPSILON * err);
         }
         
+        //! test for approx. equality, relative to the larger of x and y where it exceeds 1
+        template < typename T >
+        inline bool IsEqual(const T& x, const T& y)
+        {
+            return IsEqual(x, y, Max(T(1), Abs(x), Abs(y)));
+        }
+        
         //! limit a number to the specified range
         template < typename T >
         inline const T& Clamp(const T& x, const T& low, const T& high)
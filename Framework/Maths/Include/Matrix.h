@@ -9,6 +9,9 @@
     #pragma once
 #endif
 
+#include <sstream>
+#include <stdexcept>
+
 #include "Vector.h"
 
 namespace Framework
@@ -23,15 +26,16 @@ namespace Framework
         class Matrix : public Vector < R, Vector<C,T> >
         {
             typedef T Degree, Radian;
+            typedef Vector< R, Vector<C,T> > Rows;
             
         public:
             //! default ctor
             Matrix(){}
             
             //! overloaded ctors
-            Matrix(const Vector<2,T> &v1, const Vector<2,T> &v2): Vector(v1,v2){}
-            Matrix(const Vector<3,T> &v1, const Vector<3,T> &v2, const Vector<3,T> &v3): Vector(v1,v2,v3){}
-            Matrix(const Vector<4,T> &v1, const Vector<4,T> &v2, const Vector<4,T> &v3, const Vector<4,T> &v4): Vector(v1,v2,v3,v4){}
+            Matrix(const Vector<2,T> &v1, const Vector<2,T> &v2): Rows(v1,v2){}
+            Matrix(const Vector<3,T> &v1, const Vector<3,T> &v2, const Vector<3,T> &v3): Rows(v1,v2,v3){}
+            Matrix(const Vector<4,T> &v1, const Vector<4,T> &v2, const Vector<4,T> &v3, const Vector<4,T> &v4): Rows(v1,v2,v3,v4){}
             
             //! 2x2 overloaded ctor
             Matrix(const T &_00, const T &_01,
@@ -76,6 +80,6 @@ namespace Framework
     }
 }
 
-#include "..\source\Matrix.inl"
+#include "../Source/Matrix.inl"
 
 #endif // MATRIX_H_
@@ -0,0 +1,173 @@
+/*!
+    @file PolylineStorage.h @author Joel Barrett @date 16/10/26 @brief Polyline vertices owned by a curve or borrowed from a pool.
+*/
+
+#ifndef FRAMEWORK_MATHS_POLYLINESTORAGE_H
+#define FRAMEWORK_MATHS_POLYLINESTORAGE_H
+
+#if _MSC_VER > 1000
+    #pragma once
+#endif
+
+#include <utility>
+#include <vector>
+#include "Vector.h"
+
+namespace Framework
+{
+    namespace Maths
+    {
+        /*!
+            The vertices of a curve's polyline. By default they live in a vector the 
+            storage owns; once attached to a range of an externally owned pool they 
+            are written straight into it. Moves hand the attached range over, so 
+            curves can be moved about in a container without losing their place in 
+            the pool, but a copy owns its vertices, so that writing them can't 
+            overwrite the range the original holds. Growing beyond the attached range 
+            copies the vertices back into owned storage, which IsExternal reports. 
+            Member names follow std::vector.
+        */
+        template < std::size_t N = 3, typename T = float >
+        class PolylineStorage
+        {
+        public:
+            PolylineStorage(): external_(NULL), size_(0), capacity_(0){}
+            
+            //! a detached copy of the vertices
+            PolylineStorage(const PolylineStorage &other);
+            PolylineStorage& operator = (const PolylineStorage &other);
+            
+            //! take over the vertices and any attached range, leaving other empty and detached
+            PolylineStorage(PolylineStorage &&other) noexcept;
+            PolylineStorage& operator = (PolylineStorage &&other) noexcept;
+            
+            //! write the polyline into capacity vertices at verts from now on, adopting the first size already there
+            void Attach(Vector<N,T>* verts, std::size_t capacity, std::size_t size = 0);
+            
+            //! copy the polyline back into owned storage
+            void Detach();
+            
+            bool IsExternal() const { return external_ != NULL; }
+            
+            std::size_t size() const { return external_ ? size_ : owned_.size(); }
+            bool empty() const { return size() == 0; }
+            
+            void clear() { resize(0); }
+            void resize(std::size_t n);
+            void push_back(const Vector<N,T> &v);
+            
+            const Vector<N,T>& operator[] (std::size_t i) const { return external_ ? external_[i] : owned_[i]; }
+            Vector<N,T>& operator[] (std::size_t i) { return external_ ? external_[i] : owned_[i]; }
+            
+        private:
+            std::vector< Vector<N,T> > owned_;
+            
+            // the attached range of the pool, if any
+            Vector<N,T>* external_;
+            std::size_t size_, capacity_;
+        };
+        
+        template < std::size_t N, typename T >
+        inline PolylineStorage<N,T>::PolylineStorage(const PolylineStorage &other)
+            : external_(NULL), size_(0), capacity_(0)
+        {
+            *this = other;
+        }
+        
+        template < std::size_t N, typename T >
+        inline PolylineStorage<N,T>& PolylineStorage<N,T>::operator = (const PolylineStorage &other)
+        {
+            if (this != &other)
+            {
+                if (other.external_) {
+                    owned_.assign(other.external_, other.external_ + other.size_);
+                }
+                else {
+                    owned_ = other.owned_;
+                }
+                external_ = NULL;
+                size_ = capacity_ = 0;
+            }
+            return *this;
+        }
+        
+        template < std::size_t N, typename T >
+        inline PolylineStorage<N,T>::PolylineStorage(PolylineStorage &&other) noexcept
+            : owned_(std::move(other.owned_)), external_(other.external_), size_(other.size_), capacity_(other.capacity_)
+        {
+            other.owned_.clear();
+            other.external_ = NULL;
+            other.size_ = other.capacity_ = 0;
+        }
+        
+        template < std::size_t N, typename T >
+        inline PolylineStorage<N,T>& PolylineStorage<N,T>::operator = (PolylineStorage &&other) noexcept
+        {
+            if (this != &other)
+            {
+                owned_ = std::move(other.owned_);
+                external_ = other.external_;
+                size_ = other.size_;
+                capacity_ = other.capacity_;
+                
+                other.owned_.clear();
+                other.external_ = NULL;
+                other.size_ = other.capacity_ = 0;
+            }
+            return *this;
+        }
+        
+        template < std::size_t N, typename T >
+        inline void PolylineStorage<N,T>::Attach(Vector<N,T>* verts, std::size_t capacity, std::size_t size)
+        {
+            assert(verts && size <= capacity);
+            
+            external_ = verts;
+            capacity_ = capacity;
+            size_ = size;
+            
+            std::vector< Vector<N,T> >().swap(owned_);
+        }
+        
+        template < std::size_t N, typename T >
+        inline void PolylineStorage<N,T>::Detach()
+        {
+            if (external_)
+            {
+                owned_.assign(external_, external_ + size_);
+                external_ = NULL;
+                size_ = capacity_ = 0;
+            }
+        }
+        
+        template < std::size_t N, typename T >
+        inline void PolylineStorage<N,T>::resize(std::size_t n)
+        {
+            if (external_ && n > capacity_) {
+                Detach();
+            }
+            if (external_) {
+                size_ = n;
+            }
+            else {
+                owned_.resize(n);
+            }
+        }
+        
+        template < std::size_t N, typename T >
+        inline void PolylineStorage<N,T>::push_back(const Vector<N,T> &v)
+        {
+            if (external_ && size_ == capacity_) {
+                Detach();
+            }
+            if (external_) {
+                external_[size_++] = v;
+            }
+            else {
+                owned_.push_back(v);
+            }
+        }
+    }
+}
+
+#endif // FRAMEWORK_MATHS_POLYLINESTORAGE_H
@@ -82,6 +82,6 @@ namespace Framework
     }
 }
 
-#include "..\source\Quaternion.inl"
+#include "../Source/Quaternion.inl"
 
 #endif // QUATERNION_H_
@@ -9,6 +9,7 @@
     #pragma once
 #endif
 
+#include "AABB.h"
 #include "Vector.h"
 
 namespace Framework
@@ -37,10 +38,13 @@ namespace Framework
             
             //! ray-sphere collision test (note: ray direction must be normalised)
             T TestSphere(const Vector<3,T> &v, T r);
+            
+            //! ray-box slab test, true if the ray meets the box in front of its origin
+            bool TestAABB(const AABB<N,T> &b) const;
         };
     }
 }
 
-#include "..\source\Ray.inl"
+#include "../Source/Ray.inl"
 
 #endif // RAY_H_
@@ -0,0 +1,54 @@
+/*!
+    @file Simd.h @author Joel Barrett @date 16/10/26 @brief SIMD detection and curve kernels.
+*/
+
+#ifndef FRAMEWORK_MATHS_SIMD_H
+#define FRAMEWORK_MATHS_SIMD_H
+
+#if _MSC_VER > 1000
+    #pragma once
+#endif
+
+#if !defined(MATHS_NO_SIMD) && (defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__))
+    #define MATHS_SIMD_X86
+    #include <immintrin.h>
+    #ifdef _MSC_VER
+        #include <intrin.h>
+        #define MATHS_TARGET_AVX
+    #else
+        #define MATHS_TARGET_AVX __attribute__((target("avx")))
+    #endif
+#endif
+
+#include "Vector.h"
+
+namespace Framework
+{
+    namespace Maths
+    {
+        //! instruction sets the kernels can dispatch to, in increasing order of width
+        enum SimdLevel { SIMD_NONE, SIMD_SSE, SIMD_AVX };
+        
+        //! query the processor (and OS, for AVX state) once; the result is cached
+        SimdLevel GetSimdLevel();
+        
+        //! cap the instruction set used by the kernels, e.g. to compare paths
+        void SetSimdLevel(SimdLevel level);
+        
+        /*!
+            Write count vertices of the cubic ((a*t + b)*t + c)*t + d at t = i*h 
+            into out by forward differencing. The vectorised paths are used for 
+            Vector<3,float>, all other types take the scalar path.
+        */
+        template < std::size_t N, typename T >
+        void ForwardDifference(const Vector<N,T> &a, const Vector<N,T> &b, const Vector<N,T> &c, 
+            const Vector<N,T> &d, T h, std::size_t count, Vector<N,T>* out);
+        
+        void ForwardDifference(const Vector<3,float> &a, const Vector<3,float> &b, const Vector<3,float> &c, 
+            const Vector<3,float> &d, float h, std::size_t count, Vector<3,float>* out);
+    }
+}
+
+#include "../Source/Simd.inl"
+
+#endif // FRAMEWORK_MATHS_SIMD_H
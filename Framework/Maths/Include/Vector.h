@@ -97,6 +97,6 @@ namespace Framework
     }
 }
 
-#include "..\source\Vector.inl"
+#include "../Source/Vector.inl"
 
 #endif // VECTOR_H_
@@ -0,0 +1,89 @@
+/*!
+    @file AABB.inl @author Joel Barrett @date 16/10/26 @brief A generic axis-aligned bounding box.
+*/
+
+namespace Framework
+{
+    namespace Maths
+    {
+        template < std::size_t N, typename T >
+        AABB<N,T>::AABB(): min_(std::numeric_limits<T>::max()), max_(-std::numeric_limits<T>::max())
+        {
+        }
+        
+        template < std::size_t N, typename T >
+        AABB<N,T>::AABB(const Vector<N,T> &min, const Vector<N,T> &max): min_(min), max_(max)
+        {
+        }
+        
+        template < std::size_t N, typename T >
+        inline void AABB<N,T>::Extend(const Vector<N,T> &v)
+        {
+            for (std::size_t i = 0; i < N; ++i)
+            {
+                min_[i] = Min(min_[i], v[i]);
+                max_[i] = Max(max_[i], v[i]);
+            }
+        }
+        
+        template < std::size_t N, typename T >
+        inline void AABB<N,T>::Extend(const Vector<N,T> &centre, T radius)
+        {
+            for (std::size_t i = 0; i < N; ++i)
+            {
+                min_[i] = Min(min_[i], centre[i] - radius);
+                max_[i] = Max(max_[i], centre[i] + radius);
+            }
+        }
+        
+        template < std::size_t N, typename T >
+        inline void AABB<N,T>::Extend(const AABB<N,T> &b)
+        {
+            for (std::size_t i = 0; i < N; ++i)
+            {
+                min_[i] = Min(min_[i], b.min_[i]);
+                max_[i] = Max(max_[i], b.max_[i]);
+            }
+        }
+        
+        template < std::size_t N, typename T >
+        inline bool AABB<N,T>::Contains(const Vector<N,T> &v) const
+        {
+            for (std::size_t i = 0; i < N; ++i)
+            {
+                if (v[i] < min_[i] || v[i] > max_[i]) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        
+        template < std::size_t N, typename T >
+        inline bool AABB<N,T>::Overlaps(const AABB<N,T> &b) const
+        {
+            for (std::size_t i = 0; i < N; ++i)
+            {
+                if (b.max_[i] < min_[i] || b.min_[i] > max_[i]) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        
+        template < std::size_t N, typename T >
+        inline T AABB<N,T>::DistSqr(const Vector<N,T> &v) const
+        {
+            T d = 0.0f;
+            for (std::size_t i = 0; i < N; ++i)
+            {
+                if (v[i] < min_[i]) {
+                    d += Sqr(min_[i] - v[i]);
+                }
+                else if (v[i] > max_[i]) {
+                    d += Sqr(v[i] - max_[i]);
+                }
+            }
+            return d;
+        }
+    }
+}
@@ -0,0 +1,46 @@
+/*!
+    @file BasisTable.inl @author Joel Barrett @date 16/10/26 @brief Cubic Bernstein basis tables shared between curves.
+*/
+
+namespace Framework
+{
+    namespace Maths
+    {
+        template < typename T >
+        BasisTable<T>::BasisTable(std::size_t res): resolution_(res), weights_(4 * res)
+        {
+            assert(res > 0);
+            
+            // weights are evaluated in double so that every table entry is correctly rounded
+            for (std::size_t i = 0; i < res; ++i)
+            {
+                double t = double(i) / res, s = 1.0 - t;
+                
+                weights_[4*i + 0] = T(s * s * s);
+                weights_[4*i + 1] = T(3.0 * t * s * s);
+                weights_[4*i + 2] = T(3.0 * t * t * s);
+                weights_[4*i + 3] = T(t * t * t);
+            }
+        }
+        
+        template < typename T >
+        template < std::size_t N >
+        void BasisTable<T>::Evaluate(const Vector<N,T>* p, Vector<N,T>* out) const
+        {
+            for (std::size_t i = 0; i < resolution_; ++i)
+            {
+                const T* w = GetRow(i);
+                out[i] = p[0] * w[0] + p[1] * w[1] + p[2] * w[2] + p[3] * w[3];
+            }
+        }
+        
+        template < typename T >
+        const BasisTable<T>& BasisCache<T>::Get(std::size_t res)
+        {
+            if (table_.GetResolution() != res) {
+                table_ = BasisTable<T>(res);
+            }
+            return table_;
+        }
+    }
+}
@@ -0,0 +1,157 @@
+/*!
+    @file Bezier.inl @author Joel Barrett @date 16/10/26 @brief A bezier curve of any degree fixed at compile-time.
+*/
+
+namespace Framework
+{
+    namespace Maths
+    {
+        template < std::size_t Degree, std::size_t N, typename T >
+        Bezier<Degree,N,T>::Bezier(): Curve<N,T,Degree + 1>(ORDER,75)
+        {
+            for (std::size_t i = 0; i < ORDER; ++i) {
+                ctrlPoints_.push_back(Vector<N,T>());
+            }
+            SetResolution(75);
+            Compute();
+        }
+        
+        template < std::size_t Degree, std::size_t N, typename T >
+        Bezier<Degree,N,T>::Bezier(const Vector<N,T>* points, std::size_t res): Curve<N,T,Degree + 1>(ORDER,res)
+        {
+            SetCtrlPoints(points);
+            SetResolution(res);
+            Compute();
+        }
+        
+        template < std::size_t Degree, std::size_t N, typename T >
+        void Bezier<Degree,N,T>::SetCtrlPoints(const Vector<N,T>* points)
+        {
+            ctrlPoints_.assign(points, points + ORDER);
+        }
+        
+        template < std::size_t Degree, std::size_t N, typename T >
+        void Bezier<Degree,N,T>::SetResolution(std::size_t res)
+        {
+            assert(res > 0);
+            resolution_ = res;
+            
+            h1_ = 1.0f / res;
+        }
+        
+        template < std::size_t Degree, std::size_t N, typename T >
+        void Bezier<Degree,N,T>::ComputeCoefficients()
+        {
+            // coeffs_[j] = C(n,j) * sum_i (-1)^(j-i) C(j,i) P_i
+            for (std::size_t j = 0; j < ORDER; ++j)
+            {
+                Vector<N,T> sum = Vector<N,T>();
+                for (std::size_t i = 0; i <= j; ++i)
+                {
+                    T weight = T(Binomial(j, i));
+                    sum += ((j - i) & 1) ? ctrlPoints_[i] * -weight : ctrlPoints_[i] * weight;
+                }
+                coeffs_[j] = sum * T(Binomial(Degree, j));
+            }
+        }
+        
+        template < std::size_t Degree, std::size_t N, typename T >
+        void Bezier<Degree,N,T>::Compute()
+        {
+            ComputeCoefficients();
+            
+            // differences of every order at t = 0 straight from the coefficients, 
+            // as differencing sampled points would cancel away the higher orders
+            T powers[ORDER];
+            powers[0] = 1.0f;
+            for (std::size_t j = 1; j < ORDER; ++j) {
+                powers[j] = powers[j-1] * h1_;
+            }
+            
+            Vector<N,T> diffs[ORDER];
+            for (std::size_t k = 0; k < ORDER; ++k)
+            {
+                diffs[k] = Vector<N,T>();
+                for (std::size_t j = k; j < ORDER; ++j) {
+                    diffs[k] += coeffs_[j] * (T(PowerDifference(j, k)) * powers[j]);
+                }
+            }
+            
+            // compute the curve as a polyline by forward differencing
+            polylineVerts_.resize(resolution_);
+            for (std::size_t i = 0; i < resolution_; ++i)
+            {
+                polylineVerts_[i] = diffs[0];
+                for (std::size_t k = 0; k < Degree; ++k) {
+                    diffs[k] += diffs[k+1];
+                }
+            }
+        }
+        
+        template < std::size_t Degree, std::size_t N, typename T >
+        void Bezier<Degree,N,T>::deCasteljau(T t, Vector<N,T>* v) const
+        {
+            assert(t >= 0.0f && t <= 1.0f);
+            
+            // 1st row from the control points, each later row from the one before
+            for (std::size_t i = 0; i < Degree; ++i) {
+                v[i] = Lerp(ctrlPoints_[i], ctrlPoints_[i+1], t);
+            }
+            
+            std::size_t prev = 0, row = Degree;
+            for (std::size_t len = Degree - 1; len > 0; --len)
+            {
+                for (std::size_t i = 0; i < len; ++i) {
+                    v[row + i] = Lerp(v[prev + i], v[prev + i + 1], t);
+                }
+                prev = row;
+                row += len;
+            }
+        }
+        
+        template < std::size_t Degree, std::size_t N, typename T >
+        void Bezier<Degree,N,T>::Split(T t, Vector<N,T>* left, Vector<N,T>* right) const
+        {
+            assert(t >= 0.0f && t <= 1.0f);
+            
+            Vector<N,T> v[PYRAMID_SIZE];
+            deCasteljau(t,v);
+            
+            // the left curve runs down the first entry of each row, the right curve up the last
+            left[0] = ctrlPoints_[0];
+            right[Degree] = ctrlPoints_[Degree];
+            
+            std::size_t row = 0;
+            for (std::size_t len = Degree; len > 0; --len)
+            {
+                left[Degree - len + 1] = v[row];
+                right[len - 1] = v[row + len - 1];
+                row += len;
+            }
+        }
+        
+        template < std::size_t Degree, std::size_t N, typename T >
+        inline Vector<N,T> Bezier<Degree,N,T>::PointAt(T t) const
+        {
+            assert(t >= 0.0f && t <= 1.0f);
+            
+            Vector<N,T> p = coeffs_[Degree];
+            for (std::size_t j = Degree; j > 0; --j) {
+                p = p * t + coeffs_[j-1];
+            }
+            return p;
+        }
+        
+        template < std::size_t Degree, std::size_t N, typename T >
+        inline Vector<N,T> Bezier<Degree,N,T>::TangentAt(T t) const
+        {
+            assert(t >= 0.0f && t <= 1.0f);
+            
+            Vector<N,T> d = coeffs_[Degree] * T(Degree);
+            for (std::size_t j = Degree - 1; j > 0; --j) {
+                d = d * t + coeffs_[j] * T(j);
+            }
+            return Normalised(d);
+        }
+    }
+}
@@ -9,39 +9,37 @@
     #pragma once
 #endif
 
+#include <type_traits>
+
 namespace Framework
 {
     namespace Maths
     {
-        // Float Template Specialisations
+        /*!
+            Picks the float value for Const<float> and the double one otherwise, so the 
+            members can be defined once for all T: a specialised member would be defined 
+            anew by every source file including this one.
+        */
+        template < typename T >
+        inline constexpr T ConstValue(float f, double d)
+        {
+            return std::is_same<T, float>::value ? T(f) : T(d);
+        }
         
-        template <> const float Const<float>::PI = 3.14159f;
-        template <> const float Const<float>::TWO_PI = 6.28319f;
-        template <> const float Const<float>::HALF_PI = 1.57080f;
-        template <> const float Const<float>::INV_PI = 0.318310f;
-        template <> const float Const<float>::E = 2.71828f;
-        template <> const float Const<float>::LN2 = 0.693147f;
-        template <> const float Const<float>::LN10 = 2.30259f;
-        template <> const float Const<float>::EPSILON = 1e-06f;
-        template <> const float Const<float>::TO_DEG = 57.2958f;
-        template <> const float Const<float>::TO_HALF_DEG = 28.6479f;
-        template <> const float Const<float>::TO_RAD = 0.0174533f;
-        template <> const float Const<float>::TO_HALF_RAD = 0.00872665f;
+        template < typename T > const T Const<T>::PI = ConstValue<T>(3.14159f, 3.14159265358);
+        template < typename T > const T Const<T>::TWO_PI = ConstValue<T>(6.28319f, 6.28318530718);
+        template < typename T > const T Const<T>::HALF_PI = ConstValue<T>(1.57080f, 1.57079632679);
+        template < typename T > const T Const<T>::INV_PI = ConstValue<T>(0.318310f, 0.318309886184);
         
-        // Double Template Specialisations
+        template < typename T > const T Const<T>::E = ConstValue<T>(2.71828f, 2.71828182846);
+        template < typename T > const T Const<T>::LN2 = ConstValue<T>(0.693147f, 0.693147180560);
+        template < typename T > const T Const<T>::LN10 = ConstValue<T>(2.30259f, 2.30258509299);
+        template < typename T > const T Const<T>::EPSILON = ConstValue<T>(1e-06f, 1e-12);
         
-        template <> const double Const<double>::PI = 3.14159265358;
-        template <> const double Const<double>::TWO_PI = 6.28318530718;
-        template <> const double Const<double>::HALF_PI = 1.57079632679;
-        template <> const double Const<double>::INV_PI = 0.318309886184;
-        template <> const double Const<double>::E = 2.71828182846;
-        template <> const double Const<double>::LN2 = 0.693147180560;
-        template <> const double Const<double>::LN10 = 2.30258509299;
-        template <> const double Const<double>::EPSILON = 1e-12;
-        template <> const double Const<double>::TO_DEG = 57.2957795131;
-        template <> const double Const<double>::TO_HALF_DEG = 28.6478897565;
-        template <> const double Const<double>::TO_RAD = 0.0174532925199;
-        template <> const double Const<double>::TO_HALF_RAD = 0.00872664625997;
+        template < typename T > const T Const<T>::TO_DEG = ConstValue<T>(57.2958f, 57.2957795131);
+        template < typename T > const T Const<T>::TO_HALF_DEG = ConstValue<T>(28.6479f, 28.6478897565);
+        template < typename T > const T Const<T>::TO_RAD = ConstValue<T>(0.0174533f, 0.0174532925199);
+        template < typename T > const T Const<T>::TO_HALF_RAD = ConstValue<T>(0.00872665f, 0.00872664625997);
         
     }
 }
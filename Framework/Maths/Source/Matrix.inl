@@ -118,19 +118,23 @@ namespace Framework
         template < std::size_t R, std::size_t C, typename T >
         void Matrix<R,C,T>::Identity()
         {
-           this = IDENTITY;
-           return *this;
+            *this = IDENTITY;
         }
         
         //! matrix-matrix product
         template < std::size_t R, std::size_t C, std::size_t N, typename T, typename U >
-        inline const Matrix<R,C,T> operator * (const Matrix<R,C,T> &m1, const Matrix<C,N,U> &m2)
+        inline const Matrix<R,N,T> operator * (const Matrix<R,C,T> &m1, const Matrix<C,N,U> &m2)
         {
-            Matrix<R,C,T> ret;
-            Matrix<N,C,T> t = Transpose(m2);
+            Matrix<R,N,T> ret;
+            Matrix<N,C,T> t;
+            
+            // dot the rows of m1 with the columns of m2, which are the rows of its transpose
+            for (std::size_t i = 0; i < C; ++i)
+                for (std::size_t j = 0; j < N; ++j)
+                    t[j][i] = T(m2[i][j]);
             
             for (std::size_t i = 0; i < R; ++i)
-                for (std::size_t j = 0; j < C; ++j)
+                for (std::size_t j = 0; j < N; ++j)
                     ret[i][j] = Dot(m1[i],t[j]);
             
             return ret;
@@ -138,7 +142,7 @@ namespace Framework
         
         //! matrix-row vector product (not commutative)
         template < std::size_t R, std::size_t C, typename T, typename U >
-        inline const Vector<R,T> operator * (const Matrix<R,C,T> &m, const Vector<R,U> &v)
+        inline const Vector<R,T> operator * (const Matrix<R,C,T> &m, const Vector<C,U> &v)
         {
             Vector<R,T> ret;
             
@@ -150,12 +154,12 @@ namespace Framework
         
         //! row vector-matrix product (not commutative)
         template < std::size_t R, std::size_t C, typename T, typename U >
-        inline const Vector<R,T> operator * (const Vector<R,U> &v, const Matrix<R,C,T> &m)
+        inline const Vector<C,T> operator * (const Vector<R,U> &v, const Matrix<R,C,T> &m)
         {
-            Vector<N,T> ret;
+            Vector<C,T> ret;
             
-            for (std::size_t i = 0; i < N; ++i)
-                ret[i] += Dot(m[i],v);
+            for (std::size_t i = 0; i < R; ++i)
+                ret += m[i] * T(v[i]);
             
             return ret;
         }
@@ -187,7 +191,7 @@ namespace Framework
         
         //! get the matrix formed by removing a specified row and column
         template < std::size_t R, std::size_t C, typename T >
-        inline const Matrix<R,C,T> Cofactor(const Matrix<R,C,T> &m, std::size_t row, std::size_t col)
+        inline const Matrix<R-1,C-1,T> Cofactor(const Matrix<R,C,T> &m, std::size_t row, std::size_t col)
         {
             Matrix<R-1,C-1,T> ret;
             for (std::size_t y = 0; y < R - 1; ++y)
@@ -201,6 +205,13 @@ namespace Framework
             return ret;
         }
         
+        //! determinant of a 2x2 matrix, where the expansion by cofactors stops
+        template < typename T >
+        inline const T Determinant(const Matrix<2,2,T> &m)
+        {
+            return m[0][0] * m[1][1] - m[0][1] * m[1][0];
+        }
+        
         //! determinant of a square matrix
         template < std::size_t D, typename T >
         inline const T Determinant(const Matrix<D,D,T> &m)
@@ -211,8 +222,8 @@ namespace Framework
                 // alternately add and subtract each element in the top row
                 // times the determinant of the cofactor of that position
                 T mul(i % 2 * -2 + 1);
-                T a(mat[0][i]);
-                T b(Determinant(Cofactor(mat, 0, i)));
+                T a(m[0][i]);
+                T b(Determinant(Cofactor(m, 0, i)));
                 ret += mul * a * b;
             }
             return ret;
@@ -220,7 +231,7 @@ namespace Framework
         
         //! use cramer's method to compute inverse of a square matrix
         template < std::size_t D, typename T >
-        inline const T Cramer(const Matrix<D,D,T> &m)
+        inline const Matrix<D,D,T> Cramer(const Matrix<D,D,T> &m)
         {
             T det = Determinant(m);
             if (!det)
@@ -228,12 +239,12 @@ namespace Framework
                 // Throw an exception.
                 std::stringstream ss;
                 ss << "Attempt to take inverse of a singular matrix.\n";
-                for (std::size_t y = 0; y < Dim; ++y)
+                for (std::size_t y = 0; y < D; ++y)
                 {
                     ss << "{";
-                    for (std::size_t x = 0; x < Dim; ++x)
+                    for (std::size_t x = 0; x < D; ++x)
                     {
-                        ss << m[y][x] << (x + 1 < Dim ? ", " : "}\n");
+                        ss << m[y][x] << (x + 1 < D ? ", " : "}\n");
                     }
                 }
                 throw std::logic_error(ss.str());
@@ -248,12 +259,12 @@ namespace Framework
                     // Note: x and y are swapped in the cofactor
                     // call so that we generate the transpose of
                     // the matrix of cofactor determinants.
-                    matrix<D-1,D-1,T> c(Cofactor(m, x, y));
-                    flip = ((x + y) % 2) * Type(-2) + 1;
-                    ans[y][x] = determinant(c) * flip;
+                    Matrix<D-1,D-1,T> c(Cofactor(m, x, y));
+                    flip = ((x + y) % 2) * T(-2) + 1;
+                    ans[y][x] = Determinant(c) * flip / det;
                 }
             }
-            return ans / det;
+            return ans;
         }
         
 #ifdef MATHS_IO
@@ -37,6 +37,39 @@ namespace Framework
             
             return m_Depth = (d >= 0.0f) ? b + sqrt(d) : 0;
         }
+        
+        //! ray-box slab test, true if the ray meets the box in front of its origin
+        template < std::size_t N, typename T >
+        bool Ray<N,T>::TestAABB(const AABB<N,T> &b) const
+        {
+            T tmin = 0.0f, tmax = std::numeric_limits<T>::max();
+            
+            for (std::size_t i = 0; i < N; ++i)
+            {
+                if (m_Direction[i] == 0.0f)
+                {
+                    // parallel to the slab, so the origin must lie between its planes
+                    if (m_Origin[i] < b.GetMin()[i] || m_Origin[i] > b.GetMax()[i]) {
+                        return false;
+                    }
+                    continue;
+                }
+                
+                T inv = 1.0f / m_Direction[i];
+                T t0 = (b.GetMin()[i] - m_Origin[i]) * inv;
+                T t1 = (b.GetMax()[i] - m_Origin[i]) * inv;
+                if (t0 > t1) {
+                    Swap(t0, t1);
+                }
+                
+                tmin = Max(tmin, t0);
+                tmax = Min(tmax, t1);
+                if (tmin > tmax) {
+                    return false;
+                }
+            }
+            return true;
+        }
     }
 }
 
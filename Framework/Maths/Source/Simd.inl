@@ -0,0 +1,182 @@
+/*!
+    @file Simd.inl @author Joel Barrett @date 16/10/26 @brief SIMD detection and curve kernels.
+*/
+
+#ifndef FRAMEWORK_MATHS_SIMD_INL
+#define FRAMEWORK_MATHS_SIMD_INL
+
+#if _MSC_VER > 1000
+    #pragma once
+#endif
+
+namespace Framework
+{
+    namespace Maths
+    {
+        //! highest instruction set supported by both the processor and the OS
+        inline SimdLevel DetectSimdLevel()
+        {
+#if defined(MATHS_SIMD_X86) && defined(_MSC_VER)
+            int info[4];
+            __cpuid(info, 1);
+            
+            bool sse = (info[3] & (1 << 25)) != 0;
+            bool avx = (info[2] & (1 << 28)) != 0 && (info[2] & (1 << 27)) != 0;
+            
+            // the OS must save the ymm registers on a context switch
+            if (avx) {
+                avx = (_xgetbv(0) & 6) == 6;
+            }
+            return avx ? SIMD_AVX : (sse ? SIMD_SSE : SIMD_NONE);
+#elif defined(MATHS_SIMD_X86)
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx") ? SIMD_AVX : (__builtin_cpu_supports("sse") ? SIMD_SSE : SIMD_NONE);
+#else
+            return SIMD_NONE;
+#endif
+        }
+        
+        inline SimdLevel& ActiveSimdLevel()
+        {
+            static SimdLevel level = DetectSimdLevel();
+            return level;
+        }
+        
+        inline SimdLevel GetSimdLevel()
+        {
+            return ActiveSimdLevel();
+        }
+        
+        inline void SetSimdLevel(SimdLevel level)
+        {
+            ActiveSimdLevel() = Min(level, DetectSimdLevel());
+        }
+        
+        template < std::size_t N, typename T >
+        void ForwardDifference(const Vector<N,T> &a, const Vector<N,T> &b, const Vector<N,T> &c, 
+            const Vector<N,T> &d, T h, std::size_t count, Vector<N,T>* out)
+        {
+            if (!count) {
+                return;
+            }
+            T h2 = h * h, h3 = h2 * h;
+            
+            // forward differences
+            Vector<N,T> fd3 = 6.0f * a * h3;
+            Vector<N,T> fd2 = fd3 + 2.0f * b * h2;
+            Vector<N,T> fd1 = a * h3 + b * h2 + c * h;
+            Vector<N,T> fd0 = d;
+            
+            out[0] = fd0;
+            for (std::size_t i = 1; i < count; ++i)
+            {
+                fd0 += fd1;
+                fd1 += fd2;
+                fd2 += fd3;
+                
+                out[i] = fd0;
+            }
+        }
+        
+#ifdef MATHS_SIMD_X86
+        inline __m128 LoadXYZ(const Vector<3,float> &v)
+        {
+            return _mm_setr_ps(v.x(), v.y(), v.z(), 0.0f);
+        }
+        
+        //! the scalar recurrence with each vector held in one register
+        inline void ForwardDifferenceSSE(const Vector<3,float> &a, const Vector<3,float> &b, const Vector<3,float> &c, 
+            const Vector<3,float> &d, float h, std::size_t count, float* out)
+        {
+            float h2 = h * h, h3 = h2 * h;
+            
+            __m128 fd3 = LoadXYZ(6.0f * a * h3);
+            __m128 fd2 = _mm_add_ps(fd3, LoadXYZ(2.0f * b * h2));
+            __m128 fd1 = LoadXYZ(a * h3 + b * h2 + c * h);
+            __m128 fd0 = LoadXYZ(d);
+            
+            // each 4-wide store spills into the x of the next vertex, which is written next
+            std::size_t i = 0;
+            for (; i + 1 < count; ++i, out += 3)
+            {
+                _mm_storeu_ps(out, fd0);
+                
+                fd0 = _mm_add_ps(fd0, fd1);
+                fd1 = _mm_add_ps(fd1, fd2);
+                fd2 = _mm_add_ps(fd2, fd3);
+            }
+            float last[4];
+            _mm_storeu_ps(last, fd0);
+            out[0] = last[0]; out[1] = last[1]; out[2] = last[2];
+        }
+        
+        /*!
+            Two interleaved recurrences with a stride of 2h: the low half of each 
+            register steps through the even vertices and the high half the odd.
+        */
+        MATHS_TARGET_AVX inline void ForwardDifferenceAVX(const Vector<3,float> &a, const Vector<3,float> &b, 
+            const Vector<3,float> &c, const Vector<3,float> &d, float h, std::size_t count, float* out)
+        {
+            float s = 2.0f * h, s2 = s * s, s3 = s2 * s;
+            
+            // differences with stride s starting from t = 0 and t = h
+            Vector<3,float> fd3 = 6.0f * a * s3;
+            Vector<3,float> fd2e = fd3 + 2.0f * b * s2;
+            Vector<3,float> fd2o = a * (6.0f * h * s2 + 6.0f * s3) + 2.0f * b * s2;
+            Vector<3,float> fd1e = a * s3 + b * s2 + c * s;
+            Vector<3,float> fd1o = a * (3.0f * h * h * s + 3.0f * h * s2 + s3) + b * (2.0f * h * s + s2) + c * s;
+            Vector<3,float> fd0o = ((a * h + b) * h + c) * h + d;
+            
+            __m256 d3 = _mm256_setr_ps(fd3.x(), fd3.y(), fd3.z(), 0.0f, fd3.x(), fd3.y(), fd3.z(), 0.0f);
+            __m256 d2 = _mm256_setr_ps(fd2e.x(), fd2e.y(), fd2e.z(), 0.0f, fd2o.x(), fd2o.y(), fd2o.z(), 0.0f);
+            __m256 d1 = _mm256_setr_ps(fd1e.x(), fd1e.y(), fd1e.z(), 0.0f, fd1o.x(), fd1o.y(), fd1o.z(), 0.0f);
+            __m256 d0 = _mm256_setr_ps(d.x(), d.y(), d.z(), 0.0f, fd0o.x(), fd0o.y(), fd0o.z(), 0.0f);
+            
+            // the odd store overwrites the padding spilled by the even store
+            std::size_t i = 0;
+            for (; i + 2 < count; i += 2, out += 6)
+            {
+                _mm_storeu_ps(out, _mm256_castps256_ps128(d0));
+                _mm_storeu_ps(out + 3, _mm256_extractf128_ps(d0, 1));
+                
+                d0 = _mm256_add_ps(d0, d1);
+                d1 = _mm256_add_ps(d1, d2);
+                d2 = _mm256_add_ps(d2, d3);
+            }
+            float last[8];
+            _mm256_storeu_ps(last, d0);
+            out[0] = last[0]; out[1] = last[1]; out[2] = last[2];
+            
+            if (i + 1 < count) {
+                out[3] = last[4]; out[4] = last[5]; out[5] = last[6];
+            }
+        }
+#endif
+        
+        inline void ForwardDifference(const Vector<3,float> &a, const Vector<3,float> &b, const Vector<3,float> &c, 
+            const Vector<3,float> &d, float h, std::size_t count, Vector<3,float>* out)
+        {
+            if (!count) {
+                return;
+            }
+#ifdef MATHS_SIMD_X86
+            switch (GetSimdLevel())
+            {
+            case SIMD_AVX:
+                ForwardDifferenceAVX(a, b, c, d, h, count, &out[0].x());
+                return;
+                
+            case SIMD_SSE:
+                ForwardDifferenceSSE(a, b, c, d, h, count, &out[0].x());
+                return;
+                
+            default:
+                break;
+            }
+#endif
+            ForwardDifference<3,float>(a, b, c, d, h, count, out);
+        }
+    }
+}
+
+#endif // FRAMEWORK_MATHS_SIMD_INL
@@ -0,0 +1,76 @@
+/*!
+    @file GLRenderDevice.h @author Joel Barrett @date 16/10/26 @brief Fixed-function OpenGL render device.
+*/
+
+#ifndef FRAMEWORK_OPENGL_GLRENDERDEVICE_H
+#define FRAMEWORK_OPENGL_GLRENDERDEVICE_H
+
+#if _MSC_VER > 1000
+    #pragma once
+#endif
+
+#include "RenderDevice.h"
+
+namespace Framework
+{
+    namespace OpenGL
+    {
+        using namespace Rendering;
+
+        /*!
+            Draws through OpenGL vertex arrays, with meshes compiled into display
+            lists and buffers held in vertex buffer objects, which need OpenGL 1.5.
+            Needs a current context for everything but construction.
+        */
+        class GLRenderDevice : public RenderDevice
+        {
+        public:
+            //! depth testing, culling, smooth shading and the rest of the state the scene assumes,
+            //! throwing if the context can't hold buffers
+            void Init();
+
+            void Clear();
+
+            void SetProjection(float fovy, float aspect, float zNear, float zFar);
+            void SetView(const Vector3f &position, const Vector3f &look, const Vector3f &up);
+
+            void PushMatrix();
+            void PopMatrix();
+            void Translate(const Vector3f &v);
+            void Rotate(float degrees, const Vector3f &axis);
+
+            void SetLight(const Light &light);
+            void SetLighting(bool enable);
+
+            void SetColour(const float* rgb);
+            void SetMaterial(const float* ambient, const float* diffuse, const float* specular,
+                const float* emissive, float shininess);
+
+            int CreateTexture(const char* filename);
+            void SetTexture(int texture);
+
+            void Draw(Primitive primitive, const Vector3f* positions, std::size_t count);
+            void Draw(Primitive primitive, const Vertex* vertices, std::size_t count);
+
+            Mesh CreateMesh(Primitive primitive, const Vector3f* positions, std::size_t count);
+            Mesh CreateMesh(Primitive primitive, const Vertex* vertices, std::size_t count);
+            Mesh CreateMesh(Primitive primitive, const Vertex* vertices, std::size_t numVertices,
+                const unsigned short* indices, std::size_t count);
+            Mesh CreateMesh(Primitive primitive, const Vertex* vertices, std::size_t numVertices,
+                const unsigned int* indices, std::size_t count);
+            void DrawMesh(Mesh mesh);
+            void DestroyMesh(Mesh mesh);
+            void DrawMeshInstanced(Mesh mesh, const Instance* instances, std::size_t count);
+
+            Buffer CreateVertexBuffer(std::size_t count);
+            Buffer CreateIndexBuffer(std::size_t count);
+            void UpdateVertexBuffer(Buffer buffer, std::size_t offset, const Vector3f* positions, std::size_t count);
+            void UpdateIndexBuffer(Buffer buffer, std::size_t offset, const unsigned int* indices, std::size_t count);
+            void DrawBuffer(Primitive primitive, Buffer vertices, std::size_t first, std::size_t count);
+            void DrawIndexed(Primitive primitive, Buffer vertices, Buffer indices, std::size_t count);
+            void DestroyBuffer(Buffer buffer);
+        };
+    }
+}
+
+#endif // FRAMEWORK_OPENGL_GLRENDERDEVICE_H
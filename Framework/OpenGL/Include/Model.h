@@ -18,10 +18,16 @@
     #pragma once
 #endif
 
+#include <vector>
+
+#include "RenderDevice.h"
+
 namespace Framework
 {
     namespace OpenGL
     {
+        using Rendering::RenderDevice;
+
         class Model
         {
         public:
@@ -57,14 +63,36 @@ namespace Framework
             Model();
             virtual ~Model();
 
-            // load the model data into the private variables
+            // load the model data into the private variables, leaving textures to ReloadTextures
             virtual bool LoadModelData(const char *filename) = 0;
 
-            // draw the model
-            void Draw();
+            // draw the model from the meshes ReloadMeshes created
+            void Draw( RenderDevice &device );
+
+            // draw the model once per instance, with one draw per group, from the meshes ReloadMeshes created
+            void DrawInstanced( RenderDevice &device, const RenderDevice::Instance *pInstances, int numInstances );
 
-            // called if OpenGL context was lost and we need to reload textures, etc
-            void ReloadTextures();
+            // create the materials' textures on a device, after loading or if its context was lost
+            void ReloadTextures( RenderDevice &device );
+
+            // create a mesh per group on a device, likewise
+            void ReloadMeshes( RenderDevice &device );
+
+        protected:
+            // A group's triangles as indexed vertices, each distinct corner stored once
+            struct DrawGroup
+            {
+                std::vector<RenderDevice::Vertex> m_vertices;
+                std::vector<unsigned short> m_shortIndices;   // when there are few enough vertices
+                std::vector<unsigned int> m_indices;          // otherwise
+            };
+
+            // build the groups' vertices and indices from the loaded triangles, ordered for the vertex cache
+            void BuildDrawGroups();
+
+        private:
+            // set up a group's material, or the default material if it has none
+            void ApplyMaterial( RenderDevice &device, int meshIndex );
 
         protected:
             // Meshes used
@@ -82,6 +110,12 @@ namespace Framework
             // Vertices used
             int m_numVertices;
             Vertex *m_pVertices;
+
+            // Each group's triangles as they're handed to the device
+            std::vector<DrawGroup> m_drawGroups;
+
+            // Each group's mesh on the device ReloadMeshes was last called with
+            std::vector<RenderDevice::Mesh> m_deviceMeshes;
         };
     }
 }
@@ -0,0 +1,286 @@
+/*!
+    @file GLRenderDevice.cpp @author Joel Barrett @date 16/10/26 @brief Fixed-function OpenGL render device.
+*/
+
+#include <stdexcept>
+
+#include "glew.h"
+#include "Texture.h"
+#include "GLRenderDevice.h"
+
+namespace Framework
+{
+    namespace OpenGL
+    {
+        namespace
+        {
+            GLenum ToGL(RenderDevice::Primitive primitive)
+            {
+                switch (primitive)
+                {
+                case RenderDevice::PRIMITIVE_LINES: return GL_LINES;
+                case RenderDevice::PRIMITIVE_LINE_STRIP: return GL_LINE_STRIP;
+                default: return GL_TRIANGLES;
+                }
+            }
+
+            //! a display list of numVertices vertices drawn by indices of the given type
+            GLuint CompileElements(RenderDevice::Primitive primitive, const RenderDevice::Vertex* vertices, std::size_t numVertices,
+                GLenum type, const void* indices, std::size_t count)
+            {
+                GLuint list = glGenLists(1);
+                glNewList(list, GL_COMPILE);
+                glInterleavedArrays(GL_T2F_N3F_V3F, sizeof(RenderDevice::Vertex), vertices);
+                glDrawRangeElements(ToGL(primitive), 0, static_cast<GLuint>(numVertices - 1), static_cast<GLsizei>(count), type, indices);
+                glEndList();
+                return list;
+            }
+        }
+
+        void GLRenderDevice::Init()
+        {
+            if (glewInit() != GLEW_OK || !GLEW_VERSION_1_5) {
+                throw std::runtime_error("OpenGL 1.5 is needed for vertex buffer objects");
+            }
+
+            glHint(GL_PERSPECTIVE_CORRECTION_HINT, GL_NICEST);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+            glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+            glClearDepth(1.0f);
+            glDepthFunc(GL_LEQUAL);
+            glDepthMask(GL_TRUE);
+            glShadeModel(GL_SMOOTH);
+
+            glEnable(GL_CULL_FACE);
+            glEnable(GL_DEPTH_TEST);
+            glEnable(GL_COLOR_MATERIAL);
+            glEnable(GL_LIGHT1);
+        }
+
+        void GLRenderDevice::Clear()
+        {
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        }
+
+        void GLRenderDevice::SetProjection(float fovy, float aspect, float zNear, float zFar)
+        {
+            glMatrixMode(GL_PROJECTION);
+            glLoadIdentity();
+            gluPerspective(fovy, aspect, zNear, zFar);
+            glMatrixMode(GL_MODELVIEW);
+        }
+
+        void GLRenderDevice::SetView(const Vector3f &position, const Vector3f &look, const Vector3f &up)
+        {
+            glMatrixMode(GL_MODELVIEW);
+            glLoadIdentity();
+            gluLookAt(position.x(), position.y(), position.z(), look.x(), look.y(), look.z(), up.x(), up.y(), up.z());
+        }
+
+        void GLRenderDevice::PushMatrix()
+        {
+            glPushMatrix();
+        }
+
+        void GLRenderDevice::PopMatrix()
+        {
+            glPopMatrix();
+        }
+
+        void GLRenderDevice::Translate(const Vector3f &v)
+        {
+            glTranslatef(v.x(), v.y(), v.z());
+        }
+
+        void GLRenderDevice::Rotate(float degrees, const Vector3f &axis)
+        {
+            glRotatef(degrees, axis.x(), axis.y(), axis.z());
+        }
+
+        void GLRenderDevice::SetLight(const Light &light)
+        {
+            // the light is directional, its position the direction towards it, given in eye
+            // coordinates as the modelview matrix stands
+            float position[4] = { light.position.x(), light.position.y(), light.position.z(), 0.0f };
+            glLightfv(GL_LIGHT1, GL_AMBIENT, &light.ambient[0]);
+            glLightfv(GL_LIGHT1, GL_DIFFUSE, &light.diffuse[0]);
+            glLightfv(GL_LIGHT1, GL_POSITION, position);
+        }
+
+        void GLRenderDevice::SetLighting(bool enable)
+        {
+            if (enable) {
+                glEnable(GL_LIGHTING);
+            }
+            else {
+                glDisable(GL_LIGHTING);
+            }
+        }
+
+        void GLRenderDevice::SetColour(const float* rgb)
+        {
+            glColor3fv(rgb);
+        }
+
+        void GLRenderDevice::SetMaterial(const float* ambient, const float* diffuse, const float* specular,
+            const float* emissive, float shininess)
+        {
+            glMaterialfv(GL_FRONT, GL_AMBIENT, ambient);
+            glMaterialfv(GL_FRONT, GL_DIFFUSE, diffuse);
+            glMaterialfv(GL_FRONT, GL_SPECULAR, specular);
+            glMaterialfv(GL_FRONT, GL_EMISSION, emissive);
+            glMaterialf(GL_FRONT, GL_SHININESS, shininess);
+        }
+
+        int GLRenderDevice::CreateTexture(const char* filename)
+        {
+            GLuint texture = 0;
+            if (!CreateGLTexture(const_cast<char*>(filename), texture)) {
+                return 0;
+            }
+            return static_cast<int>(texture);
+        }
+
+        void GLRenderDevice::SetTexture(int texture)
+        {
+            if (texture > 0)
+            {
+                glBindTexture(GL_TEXTURE_2D, texture);
+                glEnable(GL_TEXTURE_2D);
+            }
+            else {
+                glDisable(GL_TEXTURE_2D);
+            }
+        }
+
+        void GLRenderDevice::Draw(Primitive primitive, const Vector3f* positions, std::size_t count)
+        {
+            glInterleavedArrays(GL_V3F, sizeof(Vector3f), positions);
+            glDrawArrays(ToGL(primitive), 0, static_cast<GLsizei>(count));
+        }
+
+        void GLRenderDevice::Draw(Primitive primitive, const Vertex* vertices, std::size_t count)
+        {
+            glInterleavedArrays(GL_T2F_N3F_V3F, sizeof(Vertex), vertices);
+            glDrawArrays(ToGL(primitive), 0, static_cast<GLsizei>(count));
+        }
+
+        RenderDevice::Mesh GLRenderDevice::CreateMesh(Primitive primitive, const Vector3f* positions, std::size_t count)
+        {
+            // a display list copies the arrays as it compiles
+            GLuint list = glGenLists(1);
+            glNewList(list, GL_COMPILE);
+            Draw(primitive, positions, count);
+            glEndList();
+            return list;
+        }
+
+        RenderDevice::Mesh GLRenderDevice::CreateMesh(Primitive primitive, const Vertex* vertices, std::size_t count)
+        {
+            GLuint list = glGenLists(1);
+            glNewList(list, GL_COMPILE);
+            Draw(primitive, vertices, count);
+            glEndList();
+            return list;
+        }
+
+        RenderDevice::Mesh GLRenderDevice::CreateMesh(Primitive primitive, const Vertex* vertices, std::size_t numVertices,
+            const unsigned short* indices, std::size_t count)
+        {
+            return CompileElements(primitive, vertices, numVertices, GL_UNSIGNED_SHORT, indices, count);
+        }
+
+        RenderDevice::Mesh GLRenderDevice::CreateMesh(Primitive primitive, const Vertex* vertices, std::size_t numVertices,
+            const unsigned int* indices, std::size_t count)
+        {
+            return CompileElements(primitive, vertices, numVertices, GL_UNSIGNED_INT, indices, count);
+        }
+
+        void GLRenderDevice::DrawMesh(Mesh mesh)
+        {
+            glCallList(mesh);
+        }
+
+        void GLRenderDevice::DestroyMesh(Mesh mesh)
+        {
+            if (mesh) {
+                glDeleteLists(mesh, 1);
+            }
+        }
+
+        void GLRenderDevice::DrawMeshInstanced(Mesh mesh, const Instance* instances, std::size_t count)
+        {
+            // the fixed-function pipeline has no per-instance attributes to read a matrix from, so
+            // each instance is a matrix load and a call of the mesh's list, with nothing else set
+            // up or sent per instance
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                glPushMatrix();
+                glMultMatrixf(instances[i].matrix);
+                glCallList(mesh);
+                glPopMatrix();
+            }
+        }
+
+        RenderDevice::Buffer GLRenderDevice::CreateVertexBuffer(std::size_t count)
+        {
+            GLuint buffer = 0;
+            glGenBuffers(1, &buffer);
+            glBindBuffer(GL_ARRAY_BUFFER, buffer);
+            glBufferData(GL_ARRAY_BUFFER, sizeof(Vector3f) * count, NULL, GL_DYNAMIC_DRAW);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            return buffer;
+        }
+
+        RenderDevice::Buffer GLRenderDevice::CreateIndexBuffer(std::size_t count)
+        {
+            GLuint buffer = 0;
+            glGenBuffers(1, &buffer);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint) * count, NULL, GL_DYNAMIC_DRAW);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+            return buffer;
+        }
+
+        void GLRenderDevice::UpdateVertexBuffer(Buffer buffer, std::size_t offset, const Vector3f* positions, std::size_t count)
+        {
+            glBindBuffer(GL_ARRAY_BUFFER, buffer);
+            glBufferSubData(GL_ARRAY_BUFFER, sizeof(Vector3f) * offset, sizeof(Vector3f) * count, positions);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+        }
+
+        void GLRenderDevice::UpdateIndexBuffer(Buffer buffer, std::size_t offset, const unsigned int* indices, std::size_t count)
+        {
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
+            glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint) * offset, sizeof(GLuint) * count, indices);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        }
+
+        void GLRenderDevice::DrawBuffer(Primitive primitive, Buffer vertices, std::size_t first, std::size_t count)
+        {
+            // with a buffer bound the array pointer is an offset into it, and it has to be unbound
+            // again before anything draws from client memory
+            glBindBuffer(GL_ARRAY_BUFFER, vertices);
+            glInterleavedArrays(GL_V3F, sizeof(Vector3f), NULL);
+            glDrawArrays(ToGL(primitive), static_cast<GLint>(first), static_cast<GLsizei>(count));
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+        }
+
+        void GLRenderDevice::DrawIndexed(Primitive primitive, Buffer vertices, Buffer indices, std::size_t count)
+        {
+            glBindBuffer(GL_ARRAY_BUFFER, vertices);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indices);
+            glInterleavedArrays(GL_V3F, sizeof(Vector3f), NULL);
+            glDrawElements(ToGL(primitive), static_cast<GLsizei>(count), GL_UNSIGNED_INT, NULL);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+        }
+
+        void GLRenderDevice::DestroyBuffer(Buffer buffer)
+        {
+            if (buffer) {
+                glDeleteBuffers(1, &buffer);
+            }
+        }
+    }
+}
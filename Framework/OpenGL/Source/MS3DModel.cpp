@@ -11,8 +11,7 @@
 	This file may be used only as long as this copyright notice remains intact.
 */
 
-#include <windows.h>
-#include <GL\gl.h>
+#include <string.h>
 #include <fstream>
 
 #include "MS3DModel.h"
@@ -191,12 +190,14 @@ namespace Framework
                 memcpy( m_pMaterials[i].m_specular, pMaterial->m_specular, sizeof( float )*4 );
                 memcpy( m_pMaterials[i].m_emissive, pMaterial->m_emissive, sizeof( float )*4 );
                 m_pMaterials[i].m_shininess = pMaterial->m_shininess;
+                m_pMaterials[i].m_texture = 0;
                 m_pMaterials[i].m_pTextureFilename = new char[strlen( pMaterial->m_texture )+1];
                 strcpy( m_pMaterials[i].m_pTextureFilename, pMaterial->m_texture );
                 pPtr += sizeof( MS3DMaterial );
             }
-            ReloadTextures();
             delete[] pBuffer;
+
+            BuildDrawGroups();
             return true;
         }
     }
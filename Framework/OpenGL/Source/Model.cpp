@@ -11,16 +11,29 @@
 	This file may be used only as long as this copyright notice remains intact.
 */
 
-#include <windows.h>
-#include <GL\gl.h>
+#include <assert.h>
+#include <string.h>
+#include <map>
 
 #include "Model.h"
-#include "Texture.h"
+#include "VertexCache.h"
 
 namespace Framework
 {
     namespace OpenGL
     {
+        namespace
+        {
+            // any strict order will do to find identical vertices, so their bytes are compared
+            struct VertexLess
+            {
+                bool operator()( const RenderDevice::Vertex &a, const RenderDevice::Vertex &b ) const
+                {
+                    return memcmp( &a, &b, sizeof( RenderDevice::Vertex ) ) < 0;
+                }
+            };
+        }
+
         Model::Model()
         {
             m_numMeshes = 0;
@@ -70,73 +83,141 @@ namespace Framework
             }
         }
 
-        void Model::Draw()
+        void Model::Draw( RenderDevice &device )
         {
-            GLboolean texEnabled = glIsEnabled( GL_TEXTURE_2D );
+            assert( m_deviceMeshes.size() == static_cast<std::size_t>( m_numMeshes ) );
 
             // Draw by group
             for ( int i = 0; i < m_numMeshes; i++ )
             {
-                int materialIndex = m_pMeshes[i].m_materialIndex;
-                if ( materialIndex >= 0 )
-                {
-                    glMaterialfv( GL_FRONT, GL_AMBIENT, m_pMaterials[materialIndex].m_ambient );
-                    glMaterialfv( GL_FRONT, GL_DIFFUSE, m_pMaterials[materialIndex].m_diffuse );
-                    glMaterialfv( GL_FRONT, GL_SPECULAR, m_pMaterials[materialIndex].m_specular );
-                    glMaterialfv( GL_FRONT, GL_EMISSION, m_pMaterials[materialIndex].m_emissive );
-                    glMaterialf( GL_FRONT, GL_SHININESS, m_pMaterials[materialIndex].m_shininess );
+                ApplyMaterial( device, i );
 
-                    if ( m_pMaterials[materialIndex].m_texture > 0 )
-                    {
-                        glBindTexture( GL_TEXTURE_2D, m_pMaterials[materialIndex].m_texture );
-                        glEnable( GL_TEXTURE_2D );
-                    }
-                    else
-                        glDisable( GL_TEXTURE_2D );
-                }
-                else
-                {
-                    // Material properties
-                    glDisable( GL_TEXTURE_2D );
-                }
+                if ( m_deviceMeshes[i] )
+                    device.DrawMesh( m_deviceMeshes[i] );
+            }
 
-                glBegin( GL_TRIANGLES );
-                {
-                    for ( int j = 0; j < m_pMeshes[i].m_numTriangles; j++ )
-                    {
-                        int triangleIndex = m_pMeshes[i].m_pTriangleIndices[j];
-                        const Triangle* pTri = &m_pTriangles[triangleIndex];
+            // nothing outside a model is textured
+            device.SetTexture( 0 );
+        }
 
-                        for ( int k = 0; k < 3; k++ )
-                        {
-                            int index = pTri->m_vertexIndices[k];
+        void Model::DrawInstanced( RenderDevice &device, const RenderDevice::Instance *pInstances, int numInstances )
+        {
+            assert( m_deviceMeshes.size() == static_cast<std::size_t>( m_numMeshes ) );
+            if ( numInstances <= 0 )
+                return;
 
-                            glNormal3fv( pTri->m_vertexNormals[k] );
-                            glTexCoord2f( pTri->m_s[k], pTri->m_t[k] );
-                            glVertex3fv( m_pVertices[index].m_location );
-                        }
-                    }
-                }
-                glEnd();
+            // every instance of a group shares its material, so it's set once for all of them
+            for ( int i = 0; i < m_numMeshes; i++ )
+            {
+                ApplyMaterial( device, i );
+
+                if ( m_deviceMeshes[i] )
+                    device.DrawMeshInstanced( m_deviceMeshes[i], pInstances, numInstances );
             }
 
-            if ( texEnabled )
-                glEnable( GL_TEXTURE_2D );
-            else
-                glDisable( GL_TEXTURE_2D );
+            device.SetTexture( 0 );
         }
 
-        void Model::ReloadTextures()
-        {	
-            GLuint temp;
+        void Model::ReloadTextures( RenderDevice &device )
+        {
             for ( int i = 0; i < m_numMaterials; i++ )
                 if ( strlen( m_pMaterials[i].m_pTextureFilename ) > 0 )
+                    m_pMaterials[i].m_texture = device.CreateTexture( m_pMaterials[i].m_pTextureFilename );
+                else
+                    m_pMaterials[i].m_texture = 0;
+        }
+
+        void Model::ReloadMeshes( RenderDevice &device )
+        {
+            assert( m_drawGroups.size() == static_cast<std::size_t>( m_numMeshes ) );
+
+            m_deviceMeshes.assign( m_numMeshes, 0 );
+            for ( int i = 0; i < m_numMeshes; i++ )
+            {
+                const DrawGroup &group = m_drawGroups[i];
+                if ( group.m_vertices.empty() )
+                    continue;
+
+                if ( !group.m_shortIndices.empty() )
+                    m_deviceMeshes[i] = device.CreateMesh( RenderDevice::PRIMITIVE_TRIANGLES, &group.m_vertices[0], group.m_vertices.size(),
+                        &group.m_shortIndices[0], group.m_shortIndices.size() );
+                else
+                    m_deviceMeshes[i] = device.CreateMesh( RenderDevice::PRIMITIVE_TRIANGLES, &group.m_vertices[0], group.m_vertices.size(),
+                        &group.m_indices[0], group.m_indices.size() );
+            }
+        }
+
+        void Model::BuildDrawGroups()
+        {
+            m_drawGroups.assign( m_numMeshes, DrawGroup() );
+            for ( int i = 0; i < m_numMeshes; i++ )
+            {
+                const Mesh &mesh = m_pMeshes[i];
+                DrawGroup &group = m_drawGroups[i];
+
+                // corners the triangles share in full, normal and texture coordinates as well as the
+                // vertex, are stored once
+                std::map<RenderDevice::Vertex, unsigned int, VertexLess> corners;
+                std::vector<unsigned int> indices( mesh.m_numTriangles * 3 );
+                for ( int j = 0; j < mesh.m_numTriangles; j++ )
+                {
+                    const Triangle* pTri = &m_pTriangles[mesh.m_pTriangleIndices[j]];
+
+                    for ( int k = 0; k < 3; k++ )
+                    {
+                        int index = pTri->m_vertexIndices[k];
+                        RenderDevice::Vertex vertex;
+
+                        vertex.normal = Vector3f( pTri->m_vertexNormals[k][0], pTri->m_vertexNormals[k][1], pTri->m_vertexNormals[k][2] );
+                        vertex.texCoord[0] = pTri->m_s[k];
+                        vertex.texCoord[1] = pTri->m_t[k];
+                        vertex.position = Vector3f( m_pVertices[index].m_location[0], m_pVertices[index].m_location[1], m_pVertices[index].m_location[2] );
+
+                        std::pair<std::map<RenderDevice::Vertex, unsigned int, VertexLess>::iterator, bool> inserted =
+                            corners.insert( std::make_pair( vertex, static_cast<unsigned int>( group.m_vertices.size() ) ) );
+                        if ( inserted.second )
+                            group.m_vertices.push_back( vertex );
+                        indices[j * 3 + k] = inserted.first->second;
+                    }
+                }
+
+                // order the triangles to reuse transformed vertices, then the vertices to be fetched in order
+                std::size_t numVertices = group.m_vertices.size();
+                if ( !indices.empty() )
                 {
-                    CreateGLTexture(m_pMaterials[i].m_pTextureFilename, temp );
-                    m_pMaterials[i].m_texture = temp;
+                    Rendering::OptimiseVertexCache( &indices[0], indices.size(), numVertices );
+
+                    std::vector<unsigned int> remap( numVertices );
+                    Rendering::OrderVerticesByFirstUse( &indices[0], indices.size(), numVertices, &remap[0] );
+
+                    std::vector<RenderDevice::Vertex> ordered( numVertices );
+                    for ( std::size_t v = 0; v < numVertices; v++ )
+                        ordered[remap[v]] = group.m_vertices[v];
+                    group.m_vertices.swap( ordered );
                 }
+
+                if ( numVertices <= 0x10000 )
+                    group.m_shortIndices.assign( indices.begin(), indices.end() );
                 else
-                    m_pMaterials[i].m_texture = 0;
+                    group.m_indices.swap( indices );
+            }
+        }
+
+        void Model::ApplyMaterial( RenderDevice &device, int meshIndex )
+        {
+            int materialIndex = m_pMeshes[meshIndex].m_materialIndex;
+            if ( materialIndex >= 0 )
+            {
+                const Material &material = m_pMaterials[materialIndex];
+                device.SetMaterial( material.m_ambient, material.m_diffuse, material.m_specular,
+                    material.m_emissive, material.m_shininess );
+                device.SetTexture( material.m_texture );
+            }
+            else
+            {
+                // Material properties
+                device.SetTexture( 0 );
+            }
         }
     }
 }
@@ -0,0 +1,151 @@
+/*!
+    @file RecordingDevice.h @author Joel Barrett @date 16/10/26 @brief A render device that records what it's asked to draw.
+*/
+
+#ifndef FRAMEWORK_RENDERING_RECORDINGDEVICE_H
+#define FRAMEWORK_RENDERING_RECORDINGDEVICE_H
+
+#if _MSC_VER > 1000
+    #pragma once
+#endif
+
+#include <vector>
+
+#include "RenderDevice.h"
+
+namespace Framework
+{
+    namespace Rendering
+    {
+        /*!
+            Draws nothing, but keeps every command it's given in memory along with
+            counts of the draw calls, vertices and state changes they make, so that
+            building a frame can be measured and checked without a graphics API.
+        */
+        class RecordingDevice : public RenderDevice
+        {
+        public:
+            enum CommandType
+            {
+                COMMAND_CLEAR, COMMAND_SET_PROJECTION, COMMAND_SET_VIEW, COMMAND_PUSH_MATRIX, COMMAND_POP_MATRIX,
+                COMMAND_TRANSLATE, COMMAND_ROTATE, COMMAND_SET_LIGHT, COMMAND_SET_LIGHTING, COMMAND_SET_COLOUR,
+                COMMAND_SET_MATERIAL, COMMAND_SET_TEXTURE, COMMAND_DRAW, COMMAND_DRAW_MESH, COMMAND_UPDATE_BUFFER,
+                COMMAND_DRAW_BUFFER, COMMAND_DRAW_INSTANCED
+            };
+
+            struct Command
+            {
+                CommandType type;
+                Primitive primitive; //!< of a draw
+                std::size_t count; //!< vertices drawn, or elements of a buffer written
+                std::size_t instances; //!< of an instanced draw
+                Mesh mesh; //!< or buffer
+                float args[4]; //!< the command's scalar arguments, such as a translation or colour
+            };
+
+            struct Stats
+            {
+                std::size_t drawCalls;
+                std::size_t vertices;
+                std::size_t stateChanges; //!< lighting, colour, material and texture
+                std::size_t transforms; //!< projection, view and matrix stack
+                std::size_t uploads; //!< buffer updates
+                std::size_t uploadedBytes;
+            };
+
+        public:
+            //! checksum hashes every vertex drawn, which costs as much as the rest of recording
+            explicit RecordingDevice(bool checksum = false);
+
+            //! forget the commands recorded so far, though not the meshes, buffers or textures
+            void Reset();
+
+            const std::vector< Command >& GetCommands() const { return commands_; }
+            const Stats& GetStats() const { return stats_; }
+
+            //! FNV-1a over the commands and vertices since the last reset, if enabled
+            unsigned int GetChecksum() const { return hash_; }
+
+            void Clear();
+
+            void SetProjection(float fovy, float aspect, float zNear, float zFar);
+            void SetView(const Vector3f &position, const Vector3f &look, const Vector3f &up);
+
+            void PushMatrix();
+            void PopMatrix();
+            void Translate(const Vector3f &v);
+            void Rotate(float degrees, const Vector3f &axis);
+
+            void SetLight(const Light &light);
+            void SetLighting(bool enable);
+
+            void SetColour(const float* rgb);
+            void SetMaterial(const float* ambient, const float* diffuse, const float* specular,
+                const float* emissive, float shininess);
+
+            int CreateTexture(const char* filename);
+            void SetTexture(int texture);
+
+            void Draw(Primitive primitive, const Vector3f* positions, std::size_t count);
+            void Draw(Primitive primitive, const Vertex* vertices, std::size_t count);
+
+            Mesh CreateMesh(Primitive primitive, const Vector3f* positions, std::size_t count);
+            Mesh CreateMesh(Primitive primitive, const Vertex* vertices, std::size_t count);
+            Mesh CreateMesh(Primitive primitive, const Vertex* vertices, std::size_t numVertices,
+                const unsigned short* indices, std::size_t count);
+            Mesh CreateMesh(Primitive primitive, const Vertex* vertices, std::size_t numVertices,
+                const unsigned int* indices, std::size_t count);
+            void DrawMesh(Mesh mesh);
+            void DestroyMesh(Mesh mesh);
+            void DrawMeshInstanced(Mesh mesh, const Instance* instances, std::size_t count);
+
+            Buffer CreateVertexBuffer(std::size_t count);
+            Buffer CreateIndexBuffer(std::size_t count);
+            void UpdateVertexBuffer(Buffer buffer, std::size_t offset, const Vector3f* positions, std::size_t count);
+            void UpdateIndexBuffer(Buffer buffer, std::size_t offset, const unsigned int* indices, std::size_t count);
+            void DrawBuffer(Primitive primitive, Buffer vertices, std::size_t first, std::size_t count);
+            void DrawIndexed(Primitive primitive, Buffer vertices, Buffer indices, std::size_t count);
+            void DestroyBuffer(Buffer buffer);
+
+        private:
+            struct MeshData
+            {
+                Primitive primitive;
+                std::size_t count;
+                unsigned int hash; //!< of its vertices
+            };
+
+            //! a buffer holds positions or indices depending on how it was created
+            struct BufferData
+            {
+                std::vector< Vector3f > positions;
+                std::vector< unsigned int > indices;
+            };
+
+            //! record a write of count elements of size bytes to a buffer
+            void RecordUpload(Buffer buffer, std::size_t offset, std::size_t count, std::size_t size);
+
+            //! record a draw from a buffer's positions, in order or picked by indices
+            void RecordBufferDraw(Primitive primitive, Buffer vertices, const unsigned int* indices,
+                std::size_t first, std::size_t count);
+
+            //! append a command with up to four scalar arguments and return it
+            Command& Record(CommandType type, float a = 0.0f, float b = 0.0f, float c = 0.0f, float d = 0.0f);
+
+            static unsigned int Hash(unsigned int hash, const void* data, std::size_t size);
+
+        private:
+            bool checksum_;
+            unsigned int hash_;
+
+            std::vector< Command > commands_;
+            Stats stats_;
+
+            std::vector< MeshData > meshes_; //!< mesh i is meshes_[i - 1]
+            std::vector< BufferData > buffers_; //!< and buffer i is buffers_[i - 1]
+            int textures_;
+        };
+    }
+}
+
+#endif // FRAMEWORK_RENDERING_RECORDINGDEVICE_H
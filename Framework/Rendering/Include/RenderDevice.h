@@ -0,0 +1,117 @@
+/*!
+    @file RenderDevice.h @author Joel Barrett @date 16/10/26 @brief Interface to the API a frame is drawn with.
+*/
+
+#ifndef FRAMEWORK_RENDERING_RENDERDEVICE_H
+#define FRAMEWORK_RENDERING_RENDERDEVICE_H
+
+#if _MSC_VER > 1000
+    #pragma once
+#endif
+
+#include <cstddef>
+
+#include "Vector.h"
+#include "Light.h"
+
+namespace Framework
+{
+    namespace Rendering
+    {
+        using namespace Maths;
+
+        /*!
+            The fixed-function drawing the scene is built from, behind an interface
+            so that a frame can be drawn with OpenGL or recorded without a context.
+            Transforms follow OpenGL: Translate and Rotate multiply the current
+            matrix, which SetView resets to the camera's.
+        */
+        class RenderDevice
+        {
+        public:
+            enum Primitive { PRIMITIVE_LINES, PRIMITIVE_LINE_STRIP, PRIMITIVE_TRIANGLES };
+
+            //! a vertex of lit geometry, laid out as OpenGL's GL_T2F_N3F_V3F
+            struct Vertex
+            {
+                float texCoord[2];
+                Vector3f normal;
+                Vector3f position;
+            };
+
+            //! geometry kept by the device between frames, 0 being none
+            typedef unsigned int Mesh;
+
+            //! where to draw one copy of a mesh: a model matrix, column-major as OpenGL takes it
+            struct Instance
+            {
+                float matrix[16];
+            };
+
+            //! positions or indices kept by the device and written a range at a time, 0 being none
+            typedef unsigned int Buffer;
+
+        public:
+            virtual ~RenderDevice(){}
+
+            //! clear the colour and depth buffers to begin a frame
+            virtual void Clear() = 0;
+
+            virtual void SetProjection(float fovy, float aspect, float zNear, float zFar) = 0;
+            virtual void SetView(const Vector3f &position, const Vector3f &look, const Vector3f &up) = 0;
+
+            virtual void PushMatrix() = 0;
+            virtual void PopMatrix() = 0;
+            virtual void Translate(const Vector3f &v) = 0;
+            virtual void Rotate(float degrees, const Vector3f &axis) = 0;
+
+            virtual void SetLight(const Light &light) = 0;
+            virtual void SetLighting(bool enable) = 0;
+
+            //! ambient and diffuse follow the colour, as with GL_COLOR_MATERIAL
+            virtual void SetColour(const float* rgb) = 0;
+            virtual void SetMaterial(const float* ambient, const float* diffuse, const float* specular,
+                const float* emissive, float shininess) = 0;
+
+            //! a texture from an image file, or 0 if it can't be loaded
+            virtual int CreateTexture(const char* filename) = 0;
+
+            //! texture 0 draws untextured
+            virtual void SetTexture(int texture) = 0;
+
+            //! unlit geometry of positions alone
+            virtual void Draw(Primitive primitive, const Vector3f* positions, std::size_t count) = 0;
+            virtual void Draw(Primitive primitive, const Vertex* vertices, std::size_t count) = 0;
+
+            //! copy geometry to the device to be drawn as often as needed
+            virtual Mesh CreateMesh(Primitive primitive, const Vector3f* positions, std::size_t count) = 0;
+            virtual Mesh CreateMesh(Primitive primitive, const Vertex* vertices, std::size_t count) = 0;
+
+            //! indexed geometry, of count indices into the vertices, in 16 bits where there are few enough
+            virtual Mesh CreateMesh(Primitive primitive, const Vertex* vertices, std::size_t numVertices,
+                const unsigned short* indices, std::size_t count) = 0;
+            virtual Mesh CreateMesh(Primitive primitive, const Vertex* vertices, std::size_t numVertices,
+                const unsigned int* indices, std::size_t count) = 0;
+            virtual void DrawMesh(Mesh mesh) = 0;
+            virtual void DestroyMesh(Mesh mesh) = 0;
+
+            //! a mesh count times over, each with its instance's matrix multiplied onto the current one
+            virtual void DrawMeshInstanced(Mesh mesh, const Instance* instances, std::size_t count) = 0;
+
+            //! room for count positions, or count indices into them, to be filled in by updates
+            virtual Buffer CreateVertexBuffer(std::size_t count) = 0;
+            virtual Buffer CreateIndexBuffer(std::size_t count) = 0;
+
+            //! overwrite count elements of a buffer from offset on, leaving the rest as they were
+            virtual void UpdateVertexBuffer(Buffer buffer, std::size_t offset, const Vector3f* positions, std::size_t count) = 0;
+            virtual void UpdateIndexBuffer(Buffer buffer, std::size_t offset, const unsigned int* indices, std::size_t count) = 0;
+
+            //! unlit geometry of count positions from first on, or of the positions the first count indices pick
+            virtual void DrawBuffer(Primitive primitive, Buffer vertices, std::size_t first, std::size_t count) = 0;
+            virtual void DrawIndexed(Primitive primitive, Buffer vertices, Buffer indices, std::size_t count) = 0;
+            virtual void DestroyBuffer(Buffer buffer) = 0;
+        };
+    }
+}
+
+#endif // FRAMEWORK_RENDERING_RENDERDEVICE_H
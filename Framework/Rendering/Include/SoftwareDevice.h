@@ -0,0 +1,258 @@
+/*!
+    @file SoftwareDevice.h @author Joel Barrett @date 16/10/26 @brief A render device that rasterises on the CPU into memory.
+*/
+
+#ifndef FRAMEWORK_RENDERING_SOFTWAREDEVICE_H
+#define FRAMEWORK_RENDERING_SOFTWAREDEVICE_H
+
+#if _MSC_VER > 1000
+    #pragma once
+#endif
+
+#include <vector>
+
+#include "Simd.h"
+#include "RenderDevice.h"
+#include "ThreadPool.h"
+
+namespace Framework
+{
+    namespace Rendering
+    {
+        using Utilities::ThreadPool;
+
+        /*!
+            Draws into a framebuffer in memory without a graphics API, following the
+            fixed-function OpenGL state the GL device sets up: depth testing with
+            GL_LEQUAL, back faces culled, smooth shading, and per-vertex lighting from
+            the one light with ambient and diffuse following the colour. The light is
+            directional, as the GL device sets it, and has no specular part. Textures
+            aren't loaded, so everything is drawn as if untextured.
+
+            Draws are transformed, lit, clipped and binned into screen tiles as they
+            are made, with instanced meshes spread over the thread pool. Finish then
+            rasterises the tiles in parallel, with SSE where the processor has it.
+        */
+        class SoftwareDevice : public RenderDevice
+        {
+        public:
+            //! the framebuffer is rasterised in squares of this many pixels a side, each by one thread
+            enum { TILE_SIZE = 64 };
+
+            //! a framebuffer of width by height pixels, drawn by threads threads, 0 meaning one per hardware thread
+            SoftwareDevice(std::size_t width, std::size_t height, std::size_t threads = 0);
+
+            //! rasterise everything drawn since Clear into the framebuffer
+            void Finish();
+
+            std::size_t GetWidth() const { return width_; }
+            std::size_t GetHeight() const { return height_; }
+            std::size_t GetNumThreads() const { return threadPool_.GetNumThreads(); }
+
+            //! the framebuffer as it stood at the last Finish, as RGB bytes from the top row down
+            const unsigned char* GetPixels() const { return &pixels_[0]; }
+
+            //! FNV-1a over the pixels, to compare frames by
+            unsigned int GetChecksum() const;
+
+            //! write the framebuffer as a binary PPM image, returning false if the file can't be written
+            bool WritePPM(const char* filename) const;
+
+            //! triangles and lines drawn since Clear that survived culling and clipping
+            std::size_t GetNumTriangles() const { return triangles_.size(); }
+            std::size_t GetNumLines() const { return lines_.size(); }
+
+            void Clear();
+
+            void SetProjection(float fovy, float aspect, float zNear, float zFar);
+            void SetView(const Vector3f &position, const Vector3f &look, const Vector3f &up);
+
+            void PushMatrix();
+            void PopMatrix();
+            void Translate(const Vector3f &v);
+            void Rotate(float degrees, const Vector3f &axis);
+
+            void SetLight(const Light &light);
+            void SetLighting(bool enable);
+
+            void SetColour(const float* rgb);
+            void SetMaterial(const float* ambient, const float* diffuse, const float* specular,
+                const float* emissive, float shininess);
+
+            int CreateTexture(const char* filename);
+            void SetTexture(int texture);
+
+            void Draw(Primitive primitive, const Vector3f* positions, std::size_t count);
+            void Draw(Primitive primitive, const Vertex* vertices, std::size_t count);
+
+            Mesh CreateMesh(Primitive primitive, const Vector3f* positions, std::size_t count);
+            Mesh CreateMesh(Primitive primitive, const Vertex* vertices, std::size_t count);
+            Mesh CreateMesh(Primitive primitive, const Vertex* vertices, std::size_t numVertices,
+                const unsigned short* indices, std::size_t count);
+            Mesh CreateMesh(Primitive primitive, const Vertex* vertices, std::size_t numVertices,
+                const unsigned int* indices, std::size_t count);
+            void DrawMesh(Mesh mesh);
+            void DestroyMesh(Mesh mesh);
+            void DrawMeshInstanced(Mesh mesh, const Instance* instances, std::size_t count);
+
+            Buffer CreateVertexBuffer(std::size_t count);
+            Buffer CreateIndexBuffer(std::size_t count);
+            void UpdateVertexBuffer(Buffer buffer, std::size_t offset, const Vector3f* positions, std::size_t count);
+            void UpdateIndexBuffer(Buffer buffer, std::size_t offset, const unsigned int* indices, std::size_t count);
+            void DrawBuffer(Primitive primitive, Buffer vertices, std::size_t first, std::size_t count);
+            void DrawIndexed(Primitive primitive, Buffer vertices, Buffer indices, std::size_t count);
+            void DestroyBuffer(Buffer buffer);
+
+        private:
+            SoftwareDevice(const SoftwareDevice &);
+            SoftwareDevice& operator = (const SoftwareDevice &);
+
+            //! a column-major 4x4 matrix, as OpenGL keeps them
+            struct Matrix
+            {
+                float m[16];
+            };
+
+            //! the state a draw is shaded with, fixed when it's made
+            struct Shading
+            {
+                Matrix transform; //!< from model to clip space
+                float normalMatrix[9]; //!< from model to eye space for normals, column-major
+                float colour[3], emissive[3];
+                bool lighting;
+                float lightDirection[3]; //!< towards the light, in eye space
+                float lightAmbient[3], lightDiffuse[3];
+            };
+
+            //! geometry as a draw hands it to the front end, lit if it has normals
+            struct Source
+            {
+                Primitive primitive;
+                const Vector3f* positions;
+                const Vector3f* normals;
+                std::size_t numVertices;
+                const unsigned int* indices; //!< NULL to take the vertices in order
+                std::size_t count;
+            };
+
+            //! a vertex transformed and lit, and projected if it's in front of the eye
+            struct ClipVertex
+            {
+                float clip[4]; //!< x, y, z and w in clip space
+                float colour[3];
+                float screen[3]; //!< x and y in pixels from the top left and depth from 0 to 1
+                float invW;
+                unsigned int outcode; //!< the planes it's outside of
+            };
+
+            //! a front-facing triangle set up for rasterising
+            struct ScreenTriangle
+            {
+                int minX, minY, maxX, maxY; //!< the pixels it can cover, inclusive and inside the viewport
+                float edgeA[3], edgeB[3], edgeX[3], edgeY[3]; //!< edge i, opposite vertex i, is a(x - x0) + b(y - y0)
+                bool topLeft[3]; //!< whether pixel centres exactly on an edge are inside
+                float invArea;
+                float z[3], invW[3];
+                float colour[3][3]; //!< divided by w, so that they interpolate in perspective
+            };
+
+            struct ScreenLine
+            {
+                int minX, minY, maxX, maxY;
+                float x[2], y[2], z[2];
+                float colour[2][3];
+            };
+
+            //! what a run of draws produces, before it's binned
+            struct Primitives
+            {
+                std::vector< ScreenTriangle > triangles;
+                std::vector< ScreenLine > lines;
+            };
+
+            struct MeshData
+            {
+                Primitive primitive;
+                std::vector< Vector3f > positions;
+                std::vector< Vector3f > normals; //!< empty for unlit geometry
+                std::vector< unsigned int > indices; //!< empty when the vertices are drawn in order
+            };
+
+            struct BufferData
+            {
+                std::vector< Vector3f > positions;
+                std::vector< unsigned int > indices;
+            };
+
+            //! the current state, with the modelview matrix multiplied by model if given
+            Shading CurrentShading(const float* model = NULL) const;
+
+            //! transform, light, clip and set up source, using vertices as scratch space; safe to call from any thread
+            void Process(const Source &source, const Shading &shading, std::vector< ClipVertex > &vertices,
+                Primitives &out) const;
+
+            //! process and bin a draw made on the calling thread
+            void Submit(const Source &source);
+
+            void ProjectVertex(ClipVertex &v) const;
+            void ClipTriangle(const ClipVertex &a, const ClipVertex &b, const ClipVertex &c, Primitives &out) const;
+            void ClipLine(const ClipVertex &a, const ClipVertex &b, Primitives &out) const;
+            void SetupTriangle(const ClipVertex &a, const ClipVertex &b, const ClipVertex &c, Primitives &out) const;
+            void SetupLine(const ClipVertex &a, const ClipVertex &b, Primitives &out) const;
+
+            //! append primitives to the frame and enter them in the bins of the tiles they cover
+            void Bin(const Primitives &primitives);
+
+            //! the part of the framebuffer a tile covers, x1 and y1 inclusive, and its scratch space
+            struct Tile
+            {
+                int x0, y0, x1, y1;
+                float* colour; //!< red, green then blue planes of TILE_SIZE rows of TILE_SIZE
+                float* depth;
+            };
+
+            //! rasterise tile number tile into the colour planes and depth given as scratch space, then copy it out to pixels_
+            void RenderTile(std::size_t tile, float* colour, float* depth);
+
+            void RasteriseScalar(const ScreenTriangle &triangle, const Tile &tile) const;
+#ifdef MATHS_SIMD_X86
+            //! four pixels at a time, from a column of the tile aligned to four
+            void RasteriseSSE(const ScreenTriangle &triangle, const Tile &tile) const;
+#endif
+            void RasteriseLine(const ScreenLine &line, const Tile &tile) const;
+
+        private:
+            std::size_t width_, height_;
+            std::size_t tilesX_, tilesY_;
+            float guardBand_; //!< how far beyond the viewport, in multiples of it, primitives go unclipped
+
+            std::vector< unsigned char > pixels_;
+
+            ThreadPool threadPool_;
+
+            // the current state
+            Matrix projection_;
+            std::vector< Matrix > modelView_; //!< the matrix stack, the current matrix last
+            float colour_[3], emissive_[3];
+            bool lighting_;
+            float lightDirection_[3], lightAmbient_[3], lightDiffuse_[3];
+
+            // the frame so far
+            std::vector< ScreenTriangle > triangles_;
+            std::vector< ScreenLine > lines_;
+
+            //! the primitives covering each tile in the order they were drawn, lines having the top bit set
+            std::vector< std::vector< unsigned int > > bins_;
+
+            //! scratch space for draws made on the calling thread, and for each chunk of an instanced draw
+            std::vector< ClipVertex > vertices_;
+            Primitives primitives_;
+            std::vector< Primitives > chunks_;
+
+            std::vector< MeshData > meshes_; //!< mesh i is meshes_[i - 1]
+            std::vector< BufferData > buffers_; //!< and buffer i is buffers_[i - 1]
+        };
+    }
+}
+
+#endif // FRAMEWORK_RENDERING_SOFTWAREDEVICE_H
@@ -0,0 +1,41 @@
+/*!
+    @file VertexCache.h @author Joel Barrett @date 16/10/26 @brief Triangle ordering for the post-transform vertex cache.
+*/
+
+#ifndef FRAMEWORK_RENDERING_VERTEXCACHE_H
+#define FRAMEWORK_RENDERING_VERTEXCACHE_H
+
+#if _MSC_VER > 1000
+    #pragma once
+#endif
+
+#include <cstddef>
+
+namespace Framework
+{
+    namespace Rendering
+    {
+        /*!
+            Reorder the triangles of an indexed triangle list so that each one reuses as
+            many as it can of the vertices the ones before it transformed, by Tom Forsyth's
+            linear-speed greedy method: vertices are scored on where they stand in a
+            simulated LRU cache and on how many of their triangles are left, and the best
+            scored triangle touching the cache is emitted next. The triangles themselves,
+            and the order of the corners within each, are left as they were.
+        */
+        void OptimiseVertexCache(unsigned int* indices, std::size_t numIndices, std::size_t numVertices);
+
+        /*!
+            Renumber the vertices in the order the indices first use them, so that fetching
+            them walks memory forwards, writing each vertex's new number to remap. Returns
+            the number of vertices used, which come first in the new order.
+        */
+        std::size_t OrderVerticesByFirstUse(unsigned int* indices, std::size_t numIndices, std::size_t numVertices,
+            unsigned int* remap);
+
+        //! average number of vertices transformed per triangle through a FIFO cache of cacheSize entries
+        float ComputeACMR(const unsigned int* indices, std::size_t numIndices, std::size_t cacheSize = 16);
+    }
+}
+
+#endif // FRAMEWORK_RENDERING_VERTEXCACHE_H
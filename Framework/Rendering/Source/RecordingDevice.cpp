@@ -0,0 +1,338 @@
+/*!
+    @file RecordingDevice.cpp @author Joel Barrett @date 16/10/26 @brief A render device that records what it's asked to draw.
+*/
+
+#include <algorithm>
+#include <cassert>
+
+#include "RecordingDevice.h"
+
+namespace Framework
+{
+    namespace Rendering
+    {
+        namespace
+        {
+            const unsigned int FNV_OFFSET = 2166136261u;
+        }
+
+        RecordingDevice::RecordingDevice(bool checksum)
+            : checksum_(checksum), textures_(0)
+        {
+            Reset();
+        }
+
+        void RecordingDevice::Reset()
+        {
+            commands_.clear();
+            stats_.drawCalls = stats_.vertices = stats_.stateChanges = stats_.transforms = 0;
+            stats_.uploads = stats_.uploadedBytes = 0;
+            hash_ = FNV_OFFSET;
+        }
+
+        void RecordingDevice::Clear()
+        {
+            Record(COMMAND_CLEAR);
+        }
+
+        void RecordingDevice::SetProjection(float fovy, float aspect, float zNear, float zFar)
+        {
+            Record(COMMAND_SET_PROJECTION, fovy, aspect, zNear, zFar);
+            ++stats_.transforms;
+        }
+
+        void RecordingDevice::SetView(const Vector3f &position, const Vector3f &look, const Vector3f &up)
+        {
+            // the arguments hold the eye alone, though the checksum covers all three
+            Record(COMMAND_SET_VIEW, position.x(), position.y(), position.z());
+            if (checksum_)
+            {
+                hash_ = Hash(hash_, &look[0], sizeof(Vector3f));
+                hash_ = Hash(hash_, &up[0], sizeof(Vector3f));
+            }
+            ++stats_.transforms;
+        }
+
+        void RecordingDevice::PushMatrix()
+        {
+            Record(COMMAND_PUSH_MATRIX);
+            ++stats_.transforms;
+        }
+
+        void RecordingDevice::PopMatrix()
+        {
+            Record(COMMAND_POP_MATRIX);
+            ++stats_.transforms;
+        }
+
+        void RecordingDevice::Translate(const Vector3f &v)
+        {
+            Record(COMMAND_TRANSLATE, v.x(), v.y(), v.z());
+            ++stats_.transforms;
+        }
+
+        void RecordingDevice::Rotate(float degrees, const Vector3f &axis)
+        {
+            Record(COMMAND_ROTATE, degrees, axis.x(), axis.y(), axis.z());
+            ++stats_.transforms;
+        }
+
+        void RecordingDevice::SetLight(const Light &light)
+        {
+            Record(COMMAND_SET_LIGHT, light.position.x(), light.position.y(), light.position.z());
+            ++stats_.stateChanges;
+        }
+
+        void RecordingDevice::SetLighting(bool enable)
+        {
+            Record(COMMAND_SET_LIGHTING, enable ? 1.0f : 0.0f);
+            ++stats_.stateChanges;
+        }
+
+        void RecordingDevice::SetColour(const float* rgb)
+        {
+            Record(COMMAND_SET_COLOUR, rgb[0], rgb[1], rgb[2]);
+            ++stats_.stateChanges;
+        }
+
+        void RecordingDevice::SetMaterial(const float* ambient, const float* diffuse, const float* specular,
+            const float* emissive, float shininess)
+        {
+            // the diffuse colour stands for the material in the arguments
+            Record(COMMAND_SET_MATERIAL, diffuse[0], diffuse[1], diffuse[2], shininess);
+            if (checksum_)
+            {
+                hash_ = Hash(hash_, ambient, sizeof(float) * 4);
+                hash_ = Hash(hash_, specular, sizeof(float) * 4);
+                hash_ = Hash(hash_, emissive, sizeof(float) * 4);
+            }
+            ++stats_.stateChanges;
+        }
+
+        int RecordingDevice::CreateTexture(const char* /*filename*/)
+        {
+            // nothing is loaded, but every texture is told apart
+            return ++textures_;
+        }
+
+        void RecordingDevice::SetTexture(int texture)
+        {
+            Record(COMMAND_SET_TEXTURE, static_cast<float>(texture));
+            ++stats_.stateChanges;
+        }
+
+        void RecordingDevice::Draw(Primitive primitive, const Vector3f* positions, std::size_t count)
+        {
+            Command &command = Record(COMMAND_DRAW, static_cast<float>(primitive));
+            command.primitive = primitive;
+            command.count = count;
+
+            if (checksum_) {
+                hash_ = Hash(hash_, positions, sizeof(Vector3f) * count);
+            }
+            ++stats_.drawCalls;
+            stats_.vertices += count;
+        }
+
+        void RecordingDevice::Draw(Primitive primitive, const Vertex* vertices, std::size_t count)
+        {
+            Command &command = Record(COMMAND_DRAW, static_cast<float>(primitive));
+            command.primitive = primitive;
+            command.count = count;
+
+            if (checksum_) {
+                hash_ = Hash(hash_, vertices, sizeof(Vertex) * count);
+            }
+            ++stats_.drawCalls;
+            stats_.vertices += count;
+        }
+
+        RenderDevice::Mesh RecordingDevice::CreateMesh(Primitive primitive, const Vector3f* positions, std::size_t count)
+        {
+            MeshData mesh = { primitive, count, Hash(FNV_OFFSET, positions, sizeof(Vector3f) * count) };
+            meshes_.push_back(mesh);
+            return static_cast<Mesh>(meshes_.size());
+        }
+
+        RenderDevice::Mesh RecordingDevice::CreateMesh(Primitive primitive, const Vertex* vertices, std::size_t count)
+        {
+            MeshData mesh = { primitive, count, Hash(FNV_OFFSET, vertices, sizeof(Vertex) * count) };
+            meshes_.push_back(mesh);
+            return static_cast<Mesh>(meshes_.size());
+        }
+
+        RenderDevice::Mesh RecordingDevice::CreateMesh(Primitive primitive, const Vertex* vertices, std::size_t numVertices,
+            const unsigned short* indices, std::size_t count)
+        {
+            MeshData mesh = { primitive, count, Hash(Hash(FNV_OFFSET, vertices, sizeof(Vertex) * numVertices),
+                indices, sizeof(unsigned short) * count) };
+            meshes_.push_back(mesh);
+            return static_cast<Mesh>(meshes_.size());
+        }
+
+        RenderDevice::Mesh RecordingDevice::CreateMesh(Primitive primitive, const Vertex* vertices, std::size_t numVertices,
+            const unsigned int* indices, std::size_t count)
+        {
+            MeshData mesh = { primitive, count, Hash(Hash(FNV_OFFSET, vertices, sizeof(Vertex) * numVertices),
+                indices, sizeof(unsigned int) * count) };
+            meshes_.push_back(mesh);
+            return static_cast<Mesh>(meshes_.size());
+        }
+
+        void RecordingDevice::DrawMesh(Mesh mesh)
+        {
+            assert(mesh > 0 && mesh <= meshes_.size());
+            const MeshData &data = meshes_[mesh - 1];
+
+            Command &command = Record(COMMAND_DRAW_MESH, static_cast<float>(data.primitive));
+            command.primitive = data.primitive;
+            command.count = data.count;
+            command.mesh = mesh;
+
+            if (checksum_) {
+                hash_ = Hash(hash_, &data.hash, sizeof(data.hash));
+            }
+            ++stats_.drawCalls;
+            stats_.vertices += data.count;
+        }
+
+        void RecordingDevice::DestroyMesh(Mesh mesh)
+        {
+            // handles aren't reused, so a destroyed mesh is only emptied
+            assert(mesh > 0 && mesh <= meshes_.size());
+            meshes_[mesh - 1].count = 0;
+        }
+
+        void RecordingDevice::DrawMeshInstanced(Mesh mesh, const Instance* instances, std::size_t count)
+        {
+            assert(mesh > 0 && mesh <= meshes_.size());
+            const MeshData &data = meshes_[mesh - 1];
+
+            Command &command = Record(COMMAND_DRAW_INSTANCED, static_cast<float>(data.primitive), static_cast<float>(count));
+            command.primitive = data.primitive;
+            command.count = data.count * count;
+            command.instances = count;
+            command.mesh = mesh;
+
+            if (checksum_)
+            {
+                hash_ = Hash(hash_, &data.hash, sizeof(data.hash));
+                hash_ = Hash(hash_, instances, sizeof(Instance) * count);
+            }
+            ++stats_.drawCalls;
+            stats_.vertices += data.count * count;
+        }
+
+        RenderDevice::Buffer RecordingDevice::CreateVertexBuffer(std::size_t count)
+        {
+            buffers_.push_back(BufferData());
+            buffers_.back().positions.resize(count);
+            return static_cast<Buffer>(buffers_.size());
+        }
+
+        RenderDevice::Buffer RecordingDevice::CreateIndexBuffer(std::size_t count)
+        {
+            buffers_.push_back(BufferData());
+            buffers_.back().indices.resize(count);
+            return static_cast<Buffer>(buffers_.size());
+        }
+
+        void RecordingDevice::UpdateVertexBuffer(Buffer buffer, std::size_t offset, const Vector3f* positions, std::size_t count)
+        {
+            assert(buffer > 0 && buffer <= buffers_.size());
+            std::vector< Vector3f > &data = buffers_[buffer - 1].positions;
+            assert(offset + count <= data.size());
+
+            std::copy(positions, positions + count, data.begin() + offset);
+            RecordUpload(buffer, offset, count, sizeof(Vector3f));
+        }
+
+        void RecordingDevice::UpdateIndexBuffer(Buffer buffer, std::size_t offset, const unsigned int* indices, std::size_t count)
+        {
+            assert(buffer > 0 && buffer <= buffers_.size());
+            std::vector< unsigned int > &data = buffers_[buffer - 1].indices;
+            assert(offset + count <= data.size());
+
+            std::copy(indices, indices + count, data.begin() + offset);
+            RecordUpload(buffer, offset, count, sizeof(unsigned int));
+        }
+
+        void RecordingDevice::DrawBuffer(Primitive primitive, Buffer vertices, std::size_t first, std::size_t count)
+        {
+            RecordBufferDraw(primitive, vertices, NULL, first, count);
+        }
+
+        void RecordingDevice::DrawIndexed(Primitive primitive, Buffer vertices, Buffer indices, std::size_t count)
+        {
+            assert(indices > 0 && indices <= buffers_.size());
+            assert(count <= buffers_[indices - 1].indices.size());
+            RecordBufferDraw(primitive, vertices, count ? &buffers_[indices - 1].indices[0] : NULL, 0, count);
+        }
+
+        void RecordingDevice::DestroyBuffer(Buffer buffer)
+        {
+            // like meshes, a destroyed buffer's handle isn't reused
+            assert(buffer > 0 && buffer <= buffers_.size());
+            BufferData().positions.swap(buffers_[buffer - 1].positions);
+            BufferData().indices.swap(buffers_[buffer - 1].indices);
+        }
+
+        void RecordingDevice::RecordUpload(Buffer buffer, std::size_t offset, std::size_t count, std::size_t size)
+        {
+            Command &command = Record(COMMAND_UPDATE_BUFFER, static_cast<float>(offset));
+            command.count = count;
+            command.mesh = buffer;
+
+            ++stats_.uploads;
+            stats_.uploadedBytes += count * size;
+        }
+
+        void RecordingDevice::RecordBufferDraw(Primitive primitive, Buffer vertices, const unsigned int* indices,
+            std::size_t first, std::size_t count)
+        {
+            assert(vertices > 0 && vertices <= buffers_.size());
+            const std::vector< Vector3f > &data = buffers_[vertices - 1].positions;
+
+            Command &command = Record(COMMAND_DRAW_BUFFER, static_cast<float>(primitive), static_cast<float>(first));
+            command.primitive = primitive;
+            command.count = count;
+            command.mesh = vertices;
+
+            // the positions drawn are hashed rather than the buffer, so that a frame hashes the
+            // same however its geometry got to the device
+            if (checksum_)
+            {
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    std::size_t j = indices ? indices[i] : first + i;
+                    assert(j < data.size());
+                    hash_ = Hash(hash_, &data[j], sizeof(Vector3f));
+                }
+            }
+            ++stats_.drawCalls;
+            stats_.vertices += count;
+        }
+
+        RecordingDevice::Command& RecordingDevice::Record(CommandType type, float a, float b, float c, float d)
+        {
+            Command command = { type, PRIMITIVE_LINES, 0, 0, 0, { a, b, c, d } };
+            commands_.push_back(command);
+
+            if (checksum_)
+            {
+                hash_ = Hash(hash_, &command.type, sizeof(command.type));
+                hash_ = Hash(hash_, command.args, sizeof(command.args));
+            }
+            return commands_.back();
+        }
+
+        unsigned int RecordingDevice::Hash(unsigned int hash, const void* data, std::size_t size)
+        {
+            const unsigned char* bytes = static_cast<const unsigned char*>(data);
+            for (std::size_t i = 0; i < size; ++i) {
+                hash = (hash ^ bytes[i]) * 16777619u;
+            }
+            return hash;
+        }
+    }
+}
@@ -0,0 +1,1072 @@
+/*!
+    @file SoftwareDevice.cpp @author Joel Barrett @date 16/10/26 @brief A render device that rasterises on the CPU into memory.
+*/
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+
+#include "SoftwareDevice.h"
+
+namespace Framework
+{
+    namespace Rendering
+    {
+        namespace
+        {
+            const unsigned int FNV_OFFSET = 2166136261u;
+
+            //! OpenGL's default ambient light for the whole scene, which the GL device leaves as it is
+            const float SCENE_AMBIENT = 0.2f;
+
+            //! instances of a mesh a thread transforms at a time
+            const std::size_t INSTANCES_PER_CHUNK = 16;
+
+            //! bin entries with this bit set are lines rather than triangles
+            const unsigned int LINE_BIT = 0x80000000u;
+
+            // the clip planes a vertex can be outside of: the viewport's, which reject primitives
+            // entirely outside one, and those primitives are actually clipped against
+            enum
+            {
+                OUT_LEFT = 1, OUT_RIGHT = 2, OUT_BOTTOM = 4, OUT_TOP = 8, OUT_NEAR = 16, OUT_FAR = 32,
+                OUT_GUARD_LEFT = 64, OUT_GUARD_RIGHT = 128, OUT_GUARD_BOTTOM = 256, OUT_GUARD_TOP = 512,
+
+                OUT_VIEWPORT = OUT_LEFT | OUT_RIGHT | OUT_BOTTOM | OUT_TOP | OUT_NEAR | OUT_FAR,
+                OUT_CLIP = OUT_NEAR | OUT_FAR | OUT_GUARD_LEFT | OUT_GUARD_RIGHT | OUT_GUARD_BOTTOM | OUT_GUARD_TOP
+            };
+
+            const unsigned int CLIP_PLANES[] = { OUT_NEAR, OUT_FAR, OUT_GUARD_LEFT, OUT_GUARD_RIGHT, OUT_GUARD_BOTTOM, OUT_GUARD_TOP };
+            const std::size_t NUM_CLIP_PLANES = sizeof(CLIP_PLANES) / sizeof(CLIP_PLANES[0]);
+
+            //! the most vertices clipping a triangle against every plane can leave
+            const std::size_t MAX_CLIPPED = 3 + NUM_CLIP_PLANES;
+
+            void LoadIdentity(float* m)
+            {
+                for (std::size_t i = 0; i < 16; ++i) {
+                    m[i] = (i % 5 == 0) ? 1.0f : 0.0f;
+                }
+            }
+
+            //! out = a * b, all column-major, out being neither
+            void MultiplyMatrix(const float* a, const float* b, float* out)
+            {
+                for (std::size_t c = 0; c < 4; ++c)
+                {
+                    for (std::size_t r = 0; r < 4; ++r) {
+                        out[c * 4 + r] = a[r] * b[c * 4] + a[4 + r] * b[c * 4 + 1] + a[8 + r] * b[c * 4 + 2] + a[12 + r] * b[c * 4 + 3];
+                    }
+                }
+            }
+
+            void PostMultiply(float* m, const float* b)
+            {
+                float a[16];
+                std::copy(m, m + 16, a);
+                MultiplyMatrix(a, b, m);
+            }
+
+            void Cross(const float* a, const float* b, float* out)
+            {
+                out[0] = a[1] * b[2] - a[2] * b[1];
+                out[1] = a[2] * b[0] - a[0] * b[2];
+                out[2] = a[0] * b[1] - a[1] * b[0];
+            }
+
+            void Normalise(float* v)
+            {
+                float length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+                if (length > 0.0f)
+                {
+                    v[0] /= length;
+                    v[1] /= length;
+                    v[2] /= length;
+                }
+            }
+
+            float Clamp(float x)
+            {
+                return std::min(std::max(x, 0.0f), 1.0f);
+            }
+
+            int FloorToInt(float x)
+            {
+                return static_cast<int>(std::floor(x));
+            }
+
+            //! how far inside a clip plane a position in clip space is, negative if outside
+            float PlaneDistance(unsigned int plane, const float* clip, float guardBand)
+            {
+                float x = clip[0], y = clip[1], z = clip[2], w = clip[3];
+                switch (plane)
+                {
+                case OUT_NEAR: return w + z;
+                case OUT_FAR: return w - z;
+                case OUT_GUARD_LEFT: return guardBand * w + x;
+                case OUT_GUARD_RIGHT: return guardBand * w - x;
+                case OUT_GUARD_BOTTOM: return guardBand * w + y;
+                default: return guardBand * w - y;
+                }
+            }
+
+            //! the position and colour t of the way from a to b, which stay linear in clip space
+            template < typename V >
+            void Lerp(const V &a, const V &b, float t, V &out)
+            {
+                for (std::size_t i = 0; i < 4; ++i) {
+                    out.clip[i] = a.clip[i] + (b.clip[i] - a.clip[i]) * t;
+                }
+                for (std::size_t i = 0; i < 3; ++i) {
+                    out.colour[i] = a.colour[i] + (b.colour[i] - a.colour[i]) * t;
+                }
+                out.outcode = 0;
+            }
+
+            unsigned int Hash(unsigned int hash, const unsigned char* bytes, std::size_t size)
+            {
+                for (std::size_t i = 0; i < size; ++i) {
+                    hash = (hash ^ bytes[i]) * 16777619u;
+                }
+                return hash;
+            }
+
+#ifdef MATHS_SIMD_X86
+            //! lanes on or inside an edge, on it only counting if it's a top or left edge
+            inline __m128 InsideEdge(__m128 e, bool topLeft)
+            {
+                return topLeft ? _mm_cmpge_ps(e, _mm_setzero_ps()) : _mm_cmpgt_ps(e, _mm_setzero_ps());
+            }
+
+            inline __m128 Select(__m128 mask, __m128 a, __m128 b)
+            {
+                return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+            }
+#endif
+        }
+
+        SoftwareDevice::SoftwareDevice(std::size_t width, std::size_t height, std::size_t threads)
+            : width_(width), height_(height), tilesX_((width + TILE_SIZE - 1) / TILE_SIZE),
+              tilesY_((height + TILE_SIZE - 1) / TILE_SIZE), guardBand_(4.0f), pixels_(width * height * 3, 0),
+              threadPool_(threads), modelView_(1), lighting_(false), bins_(tilesX_ * tilesY_)
+        {
+            assert(width > 0 && height > 0);
+            LoadIdentity(projection_.m);
+            LoadIdentity(modelView_.back().m);
+
+            // OpenGL's defaults: a white current colour, no emission, and GL_LIGHT1 black and shining down -z
+            std::fill(colour_, colour_ + 3, 1.0f);
+            std::fill(emissive_, emissive_ + 3, 0.0f);
+            std::fill(lightAmbient_, lightAmbient_ + 3, 0.0f);
+            std::fill(lightDiffuse_, lightDiffuse_ + 3, 0.0f);
+            lightDirection_[0] = lightDirection_[1] = 0.0f;
+            lightDirection_[2] = 1.0f;
+        }
+
+        void SoftwareDevice::Finish()
+        {
+            threadPool_.ParallelFor(bins_.size(), 1, [this](std::size_t begin, std::size_t end)
+            {
+                // three colour planes then depth, for one tile at a time
+                std::vector< float > scratch(4 * TILE_SIZE * TILE_SIZE);
+                for (std::size_t i = begin; i < end; ++i) {
+                    RenderTile(i, &scratch[0], &scratch[3 * TILE_SIZE * TILE_SIZE]);
+                }
+            });
+        }
+
+        unsigned int SoftwareDevice::GetChecksum() const
+        {
+            return Hash(FNV_OFFSET, &pixels_[0], pixels_.size());
+        }
+
+        bool SoftwareDevice::WritePPM(const char* filename) const
+        {
+            FILE* file = std::fopen(filename, "wb");
+            if (!file) {
+                return false;
+            }
+
+            std::fprintf(file, "P6\n%u %u\n255\n", static_cast<unsigned>(width_), static_cast<unsigned>(height_));
+            bool written = std::fwrite(&pixels_[0], 1, pixels_.size(), file) == pixels_.size();
+            return (std::fclose(file) == 0) && written;
+        }
+
+        void SoftwareDevice::Clear()
+        {
+            triangles_.clear();
+            lines_.clear();
+            for (std::size_t i = 0; i < bins_.size(); ++i) {
+                bins_[i].clear();
+            }
+        }
+
+        void SoftwareDevice::SetProjection(float fovy, float aspect, float zNear, float zFar)
+        {
+            // as gluPerspective
+            float f = 1.0f / std::tan(fovy * 3.14159265f / 360.0f);
+            float* m = projection_.m;
+            std::fill(m, m + 16, 0.0f);
+            m[0] = f / aspect;
+            m[5] = f;
+            m[10] = (zFar + zNear) / (zNear - zFar);
+            m[11] = -1.0f;
+            m[14] = 2.0f * zFar * zNear / (zNear - zFar);
+        }
+
+        void SoftwareDevice::SetView(const Vector3f &position, const Vector3f &look, const Vector3f &up)
+        {
+            // as gluLookAt
+            float f[3] = { look.x() - position.x(), look.y() - position.y(), look.z() - position.z() };
+            float u[3] = { up.x(), up.y(), up.z() };
+            float eye[3] = { position.x(), position.y(), position.z() };
+            float s[3];
+
+            Normalise(f);
+            Cross(f, u, s);
+            Normalise(s);
+            Cross(s, f, u);
+
+            float* m = modelView_.back().m;
+            for (std::size_t i = 0; i < 3; ++i)
+            {
+                m[i * 4] = s[i];
+                m[i * 4 + 1] = u[i];
+                m[i * 4 + 2] = -f[i];
+                m[i * 4 + 3] = 0.0f;
+            }
+            m[12] = -(s[0] * eye[0] + s[1] * eye[1] + s[2] * eye[2]);
+            m[13] = -(u[0] * eye[0] + u[1] * eye[1] + u[2] * eye[2]);
+            m[14] = f[0] * eye[0] + f[1] * eye[1] + f[2] * eye[2];
+            m[15] = 1.0f;
+        }
+
+        void SoftwareDevice::PushMatrix()
+        {
+            modelView_.push_back(modelView_.back());
+        }
+
+        void SoftwareDevice::PopMatrix()
+        {
+            assert(modelView_.size() > 1);
+            modelView_.pop_back();
+        }
+
+        void SoftwareDevice::Translate(const Vector3f &v)
+        {
+            float t[16];
+            LoadIdentity(t);
+            t[12] = v.x();
+            t[13] = v.y();
+            t[14] = v.z();
+            PostMultiply(modelView_.back().m, t);
+        }
+
+        void SoftwareDevice::Rotate(float degrees, const Vector3f &axis)
+        {
+            // as glRotatef
+            float a[3] = { axis.x(), axis.y(), axis.z() };
+            Normalise(a);
+
+            float radians = degrees * 3.14159265f / 180.0f;
+            float c = std::cos(radians), s = std::sin(radians), k = 1.0f - c;
+
+            float r[16];
+            LoadIdentity(r);
+            r[0] = a[0] * a[0] * k + c;
+            r[1] = a[1] * a[0] * k + a[2] * s;
+            r[2] = a[0] * a[2] * k - a[1] * s;
+            r[4] = a[0] * a[1] * k - a[2] * s;
+            r[5] = a[1] * a[1] * k + c;
+            r[6] = a[1] * a[2] * k + a[0] * s;
+            r[8] = a[0] * a[2] * k + a[1] * s;
+            r[9] = a[1] * a[2] * k - a[0] * s;
+            r[10] = a[2] * a[2] * k + c;
+            PostMultiply(modelView_.back().m, r);
+        }
+
+        void SoftwareDevice::SetLight(const Light &light)
+        {
+            // the position is a direction, taken into eye space by the modelview matrix as it stands
+            const float* m = modelView_.back().m;
+            for (std::size_t r = 0; r < 3; ++r)
+            {
+                lightDirection_[r] = m[r] * light.position.x() + m[4 + r] * light.position.y() + m[8 + r] * light.position.z();
+                lightAmbient_[r] = light.ambient[r];
+                lightDiffuse_[r] = light.diffuse[r];
+            }
+            Normalise(lightDirection_);
+        }
+
+        void SoftwareDevice::SetLighting(bool enable)
+        {
+            lighting_ = enable;
+        }
+
+        void SoftwareDevice::SetColour(const float* rgb)
+        {
+            std::copy(rgb, rgb + 3, colour_);
+        }
+
+        void SoftwareDevice::SetMaterial(const float* /*ambient*/, const float* /*diffuse*/, const float* /*specular*/,
+            const float* emissive, float /*shininess*/)
+        {
+            // ambient and diffuse follow the colour, and without a specular light there's no highlight
+            std::copy(emissive, emissive + 3, emissive_);
+        }
+
+        int SoftwareDevice::CreateTexture(const char* /*filename*/)
+        {
+            // nothing is loaded, so a model's materials draw untextured
+            return 0;
+        }
+
+        void SoftwareDevice::SetTexture(int texture)
+        {
+            assert(texture == 0);
+            (void)texture;
+        }
+
+        void SoftwareDevice::Draw(Primitive primitive, const Vector3f* positions, std::size_t count)
+        {
+            Source source = { primitive, positions, NULL, count, NULL, count };
+            Submit(source);
+        }
+
+        void SoftwareDevice::Draw(Primitive primitive, const Vertex* vertices, std::size_t count)
+        {
+            if (!count) {
+                return;
+            }
+
+            // the front end reads positions and normals separately, so the vertices are split up
+            MeshData data;
+            data.primitive = primitive;
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                data.positions.push_back(vertices[i].position);
+                data.normals.push_back(vertices[i].normal);
+            }
+
+            Source source = { primitive, &data.positions[0], &data.normals[0], count, NULL, count };
+            Submit(source);
+        }
+
+        RenderDevice::Mesh SoftwareDevice::CreateMesh(Primitive primitive, const Vector3f* positions, std::size_t count)
+        {
+            MeshData data;
+            data.primitive = primitive;
+            data.positions.assign(positions, positions + count);
+
+            meshes_.push_back(data);
+            return static_cast<Mesh>(meshes_.size());
+        }
+
+        RenderDevice::Mesh SoftwareDevice::CreateMesh(Primitive primitive, const Vertex* vertices, std::size_t count)
+        {
+            MeshData data;
+            data.primitive = primitive;
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                data.positions.push_back(vertices[i].position);
+                data.normals.push_back(vertices[i].normal);
+            }
+
+            meshes_.push_back(data);
+            return static_cast<Mesh>(meshes_.size());
+        }
+
+        RenderDevice::Mesh SoftwareDevice::CreateMesh(Primitive primitive, const Vertex* vertices, std::size_t numVertices,
+            const unsigned short* indices, std::size_t count)
+        {
+            std::vector< unsigned int > wide(indices, indices + count);
+            return CreateMesh(primitive, vertices, numVertices, count ? &wide[0] : NULL, count);
+        }
+
+        RenderDevice::Mesh SoftwareDevice::CreateMesh(Primitive primitive, const Vertex* vertices, std::size_t numVertices,
+            const unsigned int* indices, std::size_t count)
+        {
+            Mesh mesh = CreateMesh(primitive, vertices, numVertices);
+            meshes_.back().indices.assign(indices, indices + count);
+            return mesh;
+        }
+
+        void SoftwareDevice::DrawMesh(Mesh mesh)
+        {
+            assert(mesh > 0 && mesh <= meshes_.size());
+            const MeshData &data = meshes_[mesh - 1];
+            if (data.positions.empty()) {
+                return;
+            }
+
+            Source source = { data.primitive, &data.positions[0], data.normals.empty() ? NULL : &data.normals[0],
+                data.positions.size(), data.indices.empty() ? NULL : &data.indices[0],
+                data.indices.empty() ? data.positions.size() : data.indices.size() };
+            Submit(source);
+        }
+
+        void SoftwareDevice::DestroyMesh(Mesh mesh)
+        {
+            // handles aren't reused, so a destroyed mesh is only emptied
+            assert(mesh > 0 && mesh <= meshes_.size());
+            MeshData &data = meshes_[mesh - 1];
+            std::vector< Vector3f >().swap(data.positions);
+            std::vector< Vector3f >().swap(data.normals);
+            std::vector< unsigned int >().swap(data.indices);
+        }
+
+        void SoftwareDevice::DrawMeshInstanced(Mesh mesh, const Instance* instances, std::size_t count)
+        {
+            assert(mesh > 0 && mesh <= meshes_.size());
+            const MeshData &data = meshes_[mesh - 1];
+            if (data.positions.empty() || !count) {
+                return;
+            }
+
+            Source source = { data.primitive, &data.positions[0], data.normals.empty() ? NULL : &data.normals[0],
+                data.positions.size(), data.indices.empty() ? NULL : &data.indices[0],
+                data.indices.empty() ? data.positions.size() : data.indices.size() };
+
+            // chunks of instances are transformed in parallel into primitives of their own, which are
+            // then binned in the order of the chunks, so the frame doesn't depend on which thread ran which
+            std::size_t numChunks = (count + INSTANCES_PER_CHUNK - 1) / INSTANCES_PER_CHUNK;
+            if (chunks_.size() < numChunks) {
+                chunks_.resize(numChunks);
+            }
+
+            threadPool_.ParallelFor(numChunks, 1, [&](std::size_t begin, std::size_t end)
+            {
+                std::vector< ClipVertex > vertices;
+                for (std::size_t c = begin; c < end; ++c)
+                {
+                    Primitives &out = chunks_[c];
+                    out.triangles.clear();
+                    out.lines.clear();
+
+                    std::size_t last = std::min((c + 1) * INSTANCES_PER_CHUNK, count);
+                    for (std::size_t i = c * INSTANCES_PER_CHUNK; i < last; ++i) {
+                        Process(source, CurrentShading(instances[i].matrix), vertices, out);
+                    }
+                }
+            });
+
+            for (std::size_t c = 0; c < numChunks; ++c) {
+                Bin(chunks_[c]);
+            }
+        }
+
+        RenderDevice::Buffer SoftwareDevice::CreateVertexBuffer(std::size_t count)
+        {
+            buffers_.push_back(BufferData());
+            buffers_.back().positions.resize(count);
+            return static_cast<Buffer>(buffers_.size());
+        }
+
+        RenderDevice::Buffer SoftwareDevice::CreateIndexBuffer(std::size_t count)
+        {
+            buffers_.push_back(BufferData());
+            buffers_.back().indices.resize(count, 0);
+            return static_cast<Buffer>(buffers_.size());
+        }
+
+        void SoftwareDevice::UpdateVertexBuffer(Buffer buffer, std::size_t offset, const Vector3f* positions, std::size_t count)
+        {
+            assert(buffer > 0 && buffer <= buffers_.size());
+            std::vector< Vector3f > &data = buffers_[buffer - 1].positions;
+            assert(offset + count <= data.size());
+            std::copy(positions, positions + count, data.begin() + offset);
+        }
+
+        void SoftwareDevice::UpdateIndexBuffer(Buffer buffer, std::size_t offset, const unsigned int* indices, std::size_t count)
+        {
+            assert(buffer > 0 && buffer <= buffers_.size());
+            std::vector< unsigned int > &data = buffers_[buffer - 1].indices;
+            assert(offset + count <= data.size());
+            std::copy(indices, indices + count, data.begin() + offset);
+        }
+
+        void SoftwareDevice::DrawBuffer(Primitive primitive, Buffer vertices, std::size_t first, std::size_t count)
+        {
+            assert(vertices > 0 && vertices <= buffers_.size());
+            const std::vector< Vector3f > &positions = buffers_[vertices - 1].positions;
+            assert(first + count <= positions.size());
+            if (!count) {
+                return;
+            }
+
+            Source source = { primitive, &positions[first], NULL, count, NULL, count };
+            Submit(source);
+        }
+
+        void SoftwareDevice::DrawIndexed(Primitive primitive, Buffer vertices, Buffer indices, std::size_t count)
+        {
+            assert(vertices > 0 && vertices <= buffers_.size() && indices > 0 && indices <= buffers_.size());
+            const std::vector< Vector3f > &positions = buffers_[vertices - 1].positions;
+            const std::vector< unsigned int > &elements = buffers_[indices - 1].indices;
+            assert(count <= elements.size());
+            if (!count || positions.empty()) {
+                return;
+            }
+
+            Source source = { primitive, &positions[0], NULL, positions.size(), &elements[0], count };
+            Submit(source);
+        }
+
+        void SoftwareDevice::DestroyBuffer(Buffer buffer)
+        {
+            // like meshes, a destroyed buffer's handle isn't reused
+            assert(buffer > 0 && buffer <= buffers_.size());
+            BufferData().positions.swap(buffers_[buffer - 1].positions);
+            BufferData().indices.swap(buffers_[buffer - 1].indices);
+        }
+
+        SoftwareDevice::Shading SoftwareDevice::CurrentShading(const float* model) const
+        {
+            Shading shading;
+
+            Matrix modelView = modelView_.back();
+            if (model) {
+                PostMultiply(modelView.m, model);
+            }
+            MultiplyMatrix(projection_.m, modelView.m, shading.transform.m);
+
+            // normals go by the inverse transpose, whose columns are the cross products of the
+            // others, which keeps them at right angles to surfaces under any scaling. Like OpenGL
+            // without GL_NORMALIZE they're not made unit length again.
+            const float* m = modelView.m;
+            float* n = shading.normalMatrix;
+            Cross(m + 4, m + 8, n);
+            Cross(m + 8, m, n + 3);
+            Cross(m, m + 4, n + 6);
+
+            float det = m[0] * n[0] + m[1] * n[1] + m[2] * n[2];
+            if (det != 0.0f)
+            {
+                for (std::size_t i = 0; i < 9; ++i) {
+                    n[i] /= det;
+                }
+            }
+
+            std::copy(colour_, colour_ + 3, shading.colour);
+            std::copy(emissive_, emissive_ + 3, shading.emissive);
+            shading.lighting = lighting_;
+            std::copy(lightDirection_, lightDirection_ + 3, shading.lightDirection);
+            std::copy(lightAmbient_, lightAmbient_ + 3, shading.lightAmbient);
+            std::copy(lightDiffuse_, lightDiffuse_ + 3, shading.lightDiffuse);
+            return shading;
+        }
+
+        void SoftwareDevice::Process(const Source &source, const Shading &shading, std::vector< ClipVertex > &vertices,
+            Primitives &out) const
+        {
+            bool lit = shading.lighting && source.normals;
+            const float* t = shading.transform.m;
+            const float* n = shading.normalMatrix;
+
+            // every vertex is transformed and lit once, however many primitives share it
+            vertices.resize(source.numVertices);
+            for (std::size_t i = 0; i < source.numVertices; ++i)
+            {
+                ClipVertex &v = vertices[i];
+                const Vector3f &p = source.positions[i];
+                for (std::size_t r = 0; r < 4; ++r) {
+                    v.clip[r] = t[r] * p.x() + t[4 + r] * p.y() + t[8 + r] * p.z() + t[12 + r];
+                }
+
+                if (lit)
+                {
+                    const Vector3f &normal = source.normals[i];
+                    float diffuse = 0.0f;
+                    for (std::size_t r = 0; r < 3; ++r) {
+                        diffuse += (n[r] * normal.x() + n[3 + r] * normal.y() + n[6 + r] * normal.z()) * shading.lightDirection[r];
+                    }
+                    diffuse = std::max(diffuse, 0.0f);
+
+                    for (std::size_t k = 0; k < 3; ++k)
+                    {
+                        v.colour[k] = Clamp(shading.emissive[k] + shading.colour[k] * (SCENE_AMBIENT + shading.lightAmbient[k])
+                            + shading.colour[k] * shading.lightDiffuse[k] * diffuse);
+                    }
+                }
+                else {
+                    std::copy(shading.colour, shading.colour + 3, v.colour);
+                }
+
+                float x = v.clip[0], y = v.clip[1], z = v.clip[2], w = v.clip[3], g = guardBand_ * w;
+                v.outcode = (x < -w ? OUT_LEFT : 0) | (x > w ? OUT_RIGHT : 0) | (y < -w ? OUT_BOTTOM : 0) | (y > w ? OUT_TOP : 0)
+                    | (z < -w ? OUT_NEAR : 0) | (z > w ? OUT_FAR : 0) | (x < -g ? OUT_GUARD_LEFT : 0) | (x > g ? OUT_GUARD_RIGHT : 0)
+                    | (y < -g ? OUT_GUARD_BOTTOM : 0) | (y > g ? OUT_GUARD_TOP : 0);
+
+                if (!(v.outcode & OUT_CLIP)) {
+                    ProjectVertex(v);
+                }
+            }
+
+            const unsigned int* indices = source.indices;
+            std::size_t count = source.count;
+            switch (source.primitive)
+            {
+            case PRIMITIVE_TRIANGLES:
+                for (std::size_t i = 0; i + 2 < count; i += 3)
+                {
+                    const ClipVertex &a = vertices[indices ? indices[i] : i];
+                    const ClipVertex &b = vertices[indices ? indices[i + 1] : i + 1];
+                    const ClipVertex &c = vertices[indices ? indices[i + 2] : i + 2];
+
+                    if (a.outcode & b.outcode & c.outcode & OUT_VIEWPORT) {
+                        continue;
+                    }
+                    if ((a.outcode | b.outcode | c.outcode) & OUT_CLIP) {
+                        ClipTriangle(a, b, c, out);
+                    }
+                    else {
+                        SetupTriangle(a, b, c, out);
+                    }
+                }
+                break;
+
+            case PRIMITIVE_LINES:
+            case PRIMITIVE_LINE_STRIP:
+                {
+                    std::size_t step = (source.primitive == PRIMITIVE_LINES) ? 2 : 1;
+                    for (std::size_t i = 0; i + 1 < count; i += step)
+                    {
+                        const ClipVertex &a = vertices[indices ? indices[i] : i];
+                        const ClipVertex &b = vertices[indices ? indices[i + 1] : i + 1];
+
+                        if (a.outcode & b.outcode & OUT_VIEWPORT) {
+                            continue;
+                        }
+                        if ((a.outcode | b.outcode) & OUT_CLIP) {
+                            ClipLine(a, b, out);
+                        }
+                        else {
+                            SetupLine(a, b, out);
+                        }
+                    }
+                }
+                break;
+            }
+        }
+
+        void SoftwareDevice::Submit(const Source &source)
+        {
+            primitives_.triangles.clear();
+            primitives_.lines.clear();
+            Process(source, CurrentShading(), vertices_, primitives_);
+            Bin(primitives_);
+        }
+
+        void SoftwareDevice::ProjectVertex(ClipVertex &v) const
+        {
+            v.invW = 1.0f / v.clip[3];
+            v.screen[0] = (v.clip[0] * v.invW * 0.5f + 0.5f) * width_;
+            v.screen[1] = (0.5f - v.clip[1] * v.invW * 0.5f) * height_;
+            v.screen[2] = v.clip[2] * v.invW * 0.5f + 0.5f;
+        }
+
+        void SoftwareDevice::ClipTriangle(const ClipVertex &a, const ClipVertex &b, const ClipVertex &c, Primitives &out) const
+        {
+            // Sutherland-Hodgman, against only the planes one of the corners is outside of
+            ClipVertex buffers[2][MAX_CLIPPED];
+            ClipVertex* in = buffers[0], *clipped = buffers[1];
+            in[0] = a;
+            in[1] = b;
+            in[2] = c;
+            std::size_t count = 3;
+
+            unsigned int outside = (a.outcode | b.outcode | c.outcode) & OUT_CLIP;
+            for (std::size_t p = 0; p < NUM_CLIP_PLANES && count >= 3; ++p)
+            {
+                unsigned int plane = CLIP_PLANES[p];
+                if (!(outside & plane)) {
+                    continue;
+                }
+
+                std::size_t numClipped = 0;
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    const ClipVertex &from = in[i], &to = in[(i + 1) % count];
+                    float d0 = PlaneDistance(plane, from.clip, guardBand_);
+                    float d1 = PlaneDistance(plane, to.clip, guardBand_);
+
+                    if (d0 >= 0.0f) {
+                        clipped[numClipped++] = from;
+                    }
+                    if ((d0 >= 0.0f) != (d1 >= 0.0f)) {
+                        Lerp(from, to, d0 / (d0 - d1), clipped[numClipped++]);
+                    }
+                }
+                std::swap(in, clipped);
+                count = numClipped;
+            }
+
+            if (count < 3) {
+                return;
+            }
+
+            for (std::size_t i = 0; i < count; ++i) {
+                ProjectVertex(in[i]);
+            }
+            for (std::size_t i = 1; i + 1 < count; ++i) {
+                SetupTriangle(in[0], in[i], in[i + 1], out);
+            }
+        }
+
+        void SoftwareDevice::ClipLine(const ClipVertex &a, const ClipVertex &b, Primitives &out) const
+        {
+            // Liang-Barsky, narrowing the part of the line inside every plane
+            float t0 = 0.0f, t1 = 1.0f;
+            unsigned int outside = (a.outcode | b.outcode) & OUT_CLIP;
+            for (std::size_t p = 0; p < NUM_CLIP_PLANES; ++p)
+            {
+                unsigned int plane = CLIP_PLANES[p];
+                if (!(outside & plane)) {
+                    continue;
+                }
+
+                float d0 = PlaneDistance(plane, a.clip, guardBand_);
+                float d1 = PlaneDistance(plane, b.clip, guardBand_);
+                if (d0 < 0.0f && d1 < 0.0f) {
+                    return;
+                }
+                if (d0 < 0.0f) {
+                    t0 = std::max(t0, d0 / (d0 - d1));
+                }
+                else if (d1 < 0.0f) {
+                    t1 = std::min(t1, d0 / (d0 - d1));
+                }
+            }
+
+            if (t0 > t1) {
+                return;
+            }
+
+            ClipVertex from, to;
+            Lerp(a, b, t0, from);
+            Lerp(a, b, t1, to);
+            ProjectVertex(from);
+            ProjectVertex(to);
+            SetupLine(from, to, out);
+        }
+
+        void SoftwareDevice::SetupTriangle(const ClipVertex &a, const ClipVertex &b, const ClipVertex &c, Primitives &out) const
+        {
+            // counter-clockwise triangles face forwards, as OpenGL has it by default, which with y
+            // running down the screen gives them a negative area; the rest are culled
+            float area = (b.screen[0] - a.screen[0]) * (c.screen[1] - a.screen[1])
+                - (c.screen[0] - a.screen[0]) * (b.screen[1] - a.screen[1]);
+            if (!(area < 0.0f)) {
+                return;
+            }
+
+            // turned round so that the edge functions are positive inside
+            const ClipVertex* v[3] = { &a, &c, &b };
+            area = -area;
+
+            ScreenTriangle triangle;
+            float minX = v[0]->screen[0], maxX = minX, minY = v[0]->screen[1], maxY = minY;
+            for (std::size_t i = 1; i < 3; ++i)
+            {
+                minX = std::min(minX, v[i]->screen[0]);
+                maxX = std::max(maxX, v[i]->screen[0]);
+                minY = std::min(minY, v[i]->screen[1]);
+                maxY = std::max(maxY, v[i]->screen[1]);
+            }
+            triangle.minX = std::max(FloorToInt(minX), 0);
+            triangle.minY = std::max(FloorToInt(minY), 0);
+            triangle.maxX = std::min(FloorToInt(maxX), static_cast<int>(width_) - 1);
+            triangle.maxY = std::min(FloorToInt(maxY), static_cast<int>(height_) - 1);
+            if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY) {
+                return;
+            }
+
+            for (std::size_t i = 0; i < 3; ++i)
+            {
+                const ClipVertex &from = *v[(i + 1) % 3], &to = *v[(i + 2) % 3];
+                triangle.edgeA[i] = from.screen[1] - to.screen[1];
+                triangle.edgeB[i] = to.screen[0] - from.screen[0];
+
+                // measured from the same end whichever way round it's walked, so that the triangle on
+                // the other side of the edge gets exactly the negative and no pixel falls between them
+                const ClipVertex &origin = (from.screen[1] < to.screen[1]
+                    || (from.screen[1] == to.screen[1] && from.screen[0] < to.screen[0])) ? from : to;
+                triangle.edgeX[i] = origin.screen[0];
+                triangle.edgeY[i] = origin.screen[1];
+
+                // pixel centres exactly on an edge belong to the triangle on its right or below it,
+                // so that triangles sharing the edge don't both draw them
+                triangle.topLeft[i] = triangle.edgeA[i] > 0.0f || (triangle.edgeA[i] == 0.0f && triangle.edgeB[i] > 0.0f);
+
+                triangle.z[i] = v[i]->screen[2];
+                triangle.invW[i] = v[i]->invW;
+                for (std::size_t k = 0; k < 3; ++k) {
+                    triangle.colour[i][k] = v[i]->colour[k] * v[i]->invW;
+                }
+            }
+            triangle.invArea = 1.0f / area;
+
+            out.triangles.push_back(triangle);
+        }
+
+        void SoftwareDevice::SetupLine(const ClipVertex &a, const ClipVertex &b, Primitives &out) const
+        {
+            ScreenLine line;
+            const ClipVertex* v[2] = { &a, &b };
+            for (std::size_t i = 0; i < 2; ++i)
+            {
+                line.x[i] = v[i]->screen[0];
+                line.y[i] = v[i]->screen[1];
+                line.z[i] = v[i]->screen[2];
+                std::copy(v[i]->colour, v[i]->colour + 3, line.colour[i]);
+            }
+
+            line.minX = std::max(FloorToInt(std::min(line.x[0], line.x[1])), 0);
+            line.minY = std::max(FloorToInt(std::min(line.y[0], line.y[1])), 0);
+            line.maxX = std::min(FloorToInt(std::max(line.x[0], line.x[1])), static_cast<int>(width_) - 1);
+            line.maxY = std::min(FloorToInt(std::max(line.y[0], line.y[1])), static_cast<int>(height_) - 1);
+            if (line.minX > line.maxX || line.minY > line.maxY) {
+                return;
+            }
+
+            out.lines.push_back(line);
+        }
+
+        void SoftwareDevice::Bin(const Primitives &primitives)
+        {
+            for (std::size_t i = 0; i < primitives.triangles.size(); ++i)
+            {
+                const ScreenTriangle &triangle = primitives.triangles[i];
+                unsigned int index = static_cast<unsigned int>(triangles_.size());
+                triangles_.push_back(triangle);
+
+                for (int ty = triangle.minY / TILE_SIZE; ty <= triangle.maxY / TILE_SIZE; ++ty)
+                {
+                    for (int tx = triangle.minX / TILE_SIZE; tx <= triangle.maxX / TILE_SIZE; ++tx) {
+                        bins_[ty * tilesX_ + tx].push_back(index);
+                    }
+                }
+            }
+
+            for (std::size_t i = 0; i < primitives.lines.size(); ++i)
+            {
+                const ScreenLine &line = primitives.lines[i];
+                unsigned int index = static_cast<unsigned int>(lines_.size()) | LINE_BIT;
+                lines_.push_back(line);
+
+                for (int ty = line.minY / TILE_SIZE; ty <= line.maxY / TILE_SIZE; ++ty)
+                {
+                    for (int tx = line.minX / TILE_SIZE; tx <= line.maxX / TILE_SIZE; ++tx) {
+                        bins_[ty * tilesX_ + tx].push_back(index);
+                    }
+                }
+            }
+        }
+
+        void SoftwareDevice::RenderTile(std::size_t tile, float* colour, float* depth)
+        {
+            Tile target;
+            target.x0 = static_cast<int>((tile % tilesX_) * TILE_SIZE);
+            target.y0 = static_cast<int>((tile / tilesX_) * TILE_SIZE);
+            target.x1 = std::min(target.x0 + TILE_SIZE, static_cast<int>(width_)) - 1;
+            target.y1 = std::min(target.y0 + TILE_SIZE, static_cast<int>(height_)) - 1;
+            target.colour = colour;
+            target.depth = depth;
+
+            std::fill(colour, colour + 3 * TILE_SIZE * TILE_SIZE, 0.0f);
+            std::fill(depth, depth + TILE_SIZE * TILE_SIZE, 1.0f);
+
+#ifdef MATHS_SIMD_X86
+            bool sse = GetSimdLevel() >= SIMD_SSE;
+#endif
+            const std::vector< unsigned int > &bin = bins_[tile];
+            for (std::size_t i = 0; i < bin.size(); ++i)
+            {
+                if (bin[i] & LINE_BIT) {
+                    RasteriseLine(lines_[bin[i] & ~LINE_BIT], target);
+                    continue;
+                }
+#ifdef MATHS_SIMD_X86
+                if (sse) {
+                    RasteriseSSE(triangles_[bin[i]], target);
+                    continue;
+                }
+#endif
+                RasteriseScalar(triangles_[bin[i]], target);
+            }
+
+            // the tile's colours, which lighting has kept within 0 and 1, go out as bytes
+            for (int y = target.y0; y <= target.y1; ++y)
+            {
+                const float* r = colour + (y - target.y0) * TILE_SIZE;
+                const float* g = r + TILE_SIZE * TILE_SIZE;
+                const float* b = g + TILE_SIZE * TILE_SIZE;
+                unsigned char* row = &pixels_[(y * width_ + target.x0) * 3];
+
+                for (int x = 0; x <= target.x1 - target.x0; ++x)
+                {
+                    row[x * 3] = static_cast<unsigned char>(Clamp(r[x]) * 255.0f + 0.5f);
+                    row[x * 3 + 1] = static_cast<unsigned char>(Clamp(g[x]) * 255.0f + 0.5f);
+                    row[x * 3 + 2] = static_cast<unsigned char>(Clamp(b[x]) * 255.0f + 0.5f);
+                }
+            }
+        }
+
+        void SoftwareDevice::RasteriseScalar(const ScreenTriangle &triangle, const Tile &tile) const
+        {
+            float* colour[3] = { tile.colour, tile.colour + TILE_SIZE * TILE_SIZE, tile.colour + 2 * TILE_SIZE * TILE_SIZE };
+
+            int x0 = std::max(triangle.minX, tile.x0), x1 = std::min(triangle.maxX, tile.x1);
+            int y0 = std::max(triangle.minY, tile.y0), y1 = std::min(triangle.maxY, tile.y1);
+            for (int y = y0; y <= y1; ++y)
+            {
+                float py = y + 0.5f;
+                int row = (y - tile.y0) * TILE_SIZE - tile.x0;
+
+                for (int x = x0; x <= x1; ++x)
+                {
+                    float px = x + 0.5f;
+
+                    float e[3];
+                    bool inside = true;
+                    for (std::size_t i = 0; i < 3; ++i)
+                    {
+                        e[i] = triangle.edgeA[i] * (px - triangle.edgeX[i]) + triangle.edgeB[i] * (py - triangle.edgeY[i]);
+                        inside = inside && (e[i] > 0.0f || (e[i] == 0.0f && triangle.topLeft[i]));
+                    }
+                    if (!inside) {
+                        continue;
+                    }
+
+                    float l0 = e[0] * triangle.invArea, l1 = e[1] * triangle.invArea, l2 = e[2] * triangle.invArea;
+                    float z = l0 * triangle.z[0] + l1 * triangle.z[1] + l2 * triangle.z[2];
+                    float &depth = tile.depth[row + x];
+                    if (!(z <= depth)) {
+                        continue;
+                    }
+                    depth = z;
+
+                    float w = l0 * triangle.invW[0] + l1 * triangle.invW[1] + l2 * triangle.invW[2];
+                    for (std::size_t k = 0; k < 3; ++k)
+                    {
+                        colour[k][row + x] = (l0 * triangle.colour[0][k] + l1 * triangle.colour[1][k] + l2 * triangle.colour[2][k]) / w;
+                    }
+                }
+            }
+        }
+
+#ifdef MATHS_SIMD_X86
+        void SoftwareDevice::RasteriseSSE(const ScreenTriangle &triangle, const Tile &tile) const
+        {
+            // the same sums as the scalar path lane by lane, so the two draw exactly the same pixels
+            float* colour[3] = { tile.colour, tile.colour + TILE_SIZE * TILE_SIZE, tile.colour + 2 * TILE_SIZE * TILE_SIZE };
+
+            int x0 = std::max(triangle.minX, tile.x0), x1 = std::min(triangle.maxX, tile.x1);
+            int y0 = std::max(triangle.minY, tile.y0), y1 = std::min(triangle.maxY, tile.y1);
+
+            // the rows are walked four pixels at a time from a column aligned to four within the tile,
+            // with the pixels either side of the triangle's box masked off
+            int start = tile.x0 + ((x0 - tile.x0) & ~3);
+            __m128 first = _mm_set1_ps(x0 + 0.5f), last = _mm_set1_ps(x1 + 0.5f);
+            __m128 offsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+
+            __m128 a[3], ex[3];
+            for (std::size_t i = 0; i < 3; ++i)
+            {
+                a[i] = _mm_set1_ps(triangle.edgeA[i]);
+                ex[i] = _mm_set1_ps(triangle.edgeX[i]);
+            }
+            __m128 invArea = _mm_set1_ps(triangle.invArea);
+
+            for (int y = y0; y <= y1; ++y)
+            {
+                float py = y + 0.5f;
+                int row = (y - tile.y0) * TILE_SIZE - tile.x0;
+
+                __m128 rowTerm[3];
+                for (std::size_t i = 0; i < 3; ++i) {
+                    rowTerm[i] = _mm_set1_ps(triangle.edgeB[i] * (py - triangle.edgeY[i]));
+                }
+
+                for (int x = start; x <= x1; x += 4)
+                {
+                    __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), offsets);
+                    __m128 mask = _mm_and_ps(_mm_cmpge_ps(px, first), _mm_cmple_ps(px, last));
+
+                    __m128 e[3];
+                    for (std::size_t i = 0; i < 3; ++i)
+                    {
+                        e[i] = _mm_add_ps(_mm_mul_ps(a[i], _mm_sub_ps(px, ex[i])), rowTerm[i]);
+                        mask = _mm_and_ps(mask, InsideEdge(e[i], triangle.topLeft[i]));
+                    }
+                    if (!_mm_movemask_ps(mask)) {
+                        continue;
+                    }
+
+                    __m128 l0 = _mm_mul_ps(e[0], invArea), l1 = _mm_mul_ps(e[1], invArea), l2 = _mm_mul_ps(e[2], invArea);
+                    __m128 z = _mm_add_ps(_mm_add_ps(_mm_mul_ps(l0, _mm_set1_ps(triangle.z[0])),
+                        _mm_mul_ps(l1, _mm_set1_ps(triangle.z[1]))), _mm_mul_ps(l2, _mm_set1_ps(triangle.z[2])));
+
+                    float* depth = tile.depth + row + x;
+                    __m128 oldDepth = _mm_loadu_ps(depth);
+                    mask = _mm_and_ps(mask, _mm_cmple_ps(z, oldDepth));
+                    if (!_mm_movemask_ps(mask)) {
+                        continue;
+                    }
+                    _mm_storeu_ps(depth, Select(mask, z, oldDepth));
+
+                    __m128 w = _mm_add_ps(_mm_add_ps(_mm_mul_ps(l0, _mm_set1_ps(triangle.invW[0])),
+                        _mm_mul_ps(l1, _mm_set1_ps(triangle.invW[1]))), _mm_mul_ps(l2, _mm_set1_ps(triangle.invW[2])));
+                    for (std::size_t k = 0; k < 3; ++k)
+                    {
+                        __m128 c = _mm_add_ps(_mm_add_ps(_mm_mul_ps(l0, _mm_set1_ps(triangle.colour[0][k])),
+                            _mm_mul_ps(l1, _mm_set1_ps(triangle.colour[1][k]))), _mm_mul_ps(l2, _mm_set1_ps(triangle.colour[2][k])));
+                        float* out = colour[k] + row + x;
+                        _mm_storeu_ps(out, Select(mask, _mm_div_ps(c, w), _mm_loadu_ps(out)));
+                    }
+                }
+            }
+        }
+#endif
+
+        void SoftwareDevice::RasteriseLine(const ScreenLine &line, const Tile &tile) const
+        {
+            // a pixel along the longer axis for every centre from the start of the line up to, but
+            // not including, its end, so that the lines of a strip don't draw their joins twice
+            float dx = line.x[1] - line.x[0], dy = line.y[1] - line.y[0];
+            bool alongX = std::fabs(dx) >= std::fabs(dy);
+            float length = alongX ? dx : dy;
+            if (length == 0.0f) {
+                return;
+            }
+
+            float from = alongX ? line.x[0] : line.y[0], to = alongX ? line.x[1] : line.y[1];
+            int first = static_cast<int>(std::ceil(std::min(from, to) - 0.5f));
+            int last = static_cast<int>(std::ceil(std::max(from, to) - 0.5f)) - 1;
+            first = std::max(first, alongX ? tile.x0 : tile.y0);
+            last = std::min(last, alongX ? tile.x1 : tile.y1);
+
+            for (int i = first; i <= last; ++i)
+            {
+                float t = (i + 0.5f - from) / length;
+                int x = alongX ? i : FloorToInt(line.x[0] + t * dx);
+                int y = alongX ? FloorToInt(line.y[0] + t * dy) : i;
+                if (x < tile.x0 || x > tile.x1 || y < tile.y0 || y > tile.y1) {
+                    continue;
+                }
+
+                std::size_t index = (y - tile.y0) * TILE_SIZE + (x - tile.x0);
+                float z = line.z[0] + t * (line.z[1] - line.z[0]);
+                if (!(z <= tile.depth[index])) {
+                    continue;
+                }
+                tile.depth[index] = z;
+
+                for (std::size_t k = 0; k < 3; ++k) {
+                    tile.colour[k * TILE_SIZE * TILE_SIZE + index] = line.colour[0][k] + t * (line.colour[1][k] - line.colour[0][k]);
+                }
+            }
+        }
+    }
+}
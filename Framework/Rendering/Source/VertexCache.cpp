@@ -0,0 +1,215 @@
+/*!
+    @file VertexCache.cpp @author Joel Barrett @date 16/10/26 @brief Triangle ordering for the post-transform vertex cache.
+*/
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+#include "VertexCache.h"
+
+namespace Framework
+{
+    namespace Rendering
+    {
+        namespace
+        {
+            // the weights from Forsyth's paper, tuned for a cache of 32 entries but good for smaller ones
+            const std::size_t CACHE_SIZE = 32;
+            const float CACHE_DECAY_POWER = 1.5f;
+            const float LAST_TRIANGLE_SCORE = 0.75f;
+            const float VALENCE_BOOST_SCALE = 2.0f;
+            const float VALENCE_BOOST_POWER = 0.5f;
+
+            const unsigned int NONE = ~0u;
+
+            //! how much a vertex at cachePosition, or -1 if it isn't cached, with remaining triangles to go wants to be used
+            float ScoreVertex(int cachePosition, std::size_t remaining)
+            {
+                if (!remaining) {
+                    return -1.0f;
+                }
+
+                float score = 0.0f;
+                if (cachePosition >= 0)
+                {
+                    // the three vertices of the triangle just emitted score the same, so that it
+                    // doesn't matter which way round it was
+                    if (cachePosition < 3) {
+                        score = LAST_TRIANGLE_SCORE;
+                    }
+                    else
+                    {
+                        float scale = 1.0f / (CACHE_SIZE - 3);
+                        score = std::pow(1.0f - (cachePosition - 3) * scale, CACHE_DECAY_POWER);
+                    }
+                }
+
+                // favour vertices with few triangles left, so that none are stranded to be fetched again later
+                return score + VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remaining), -VALENCE_BOOST_POWER);
+            }
+        }
+
+        void OptimiseVertexCache(unsigned int* indices, std::size_t numIndices, std::size_t numVertices)
+        {
+            assert(numIndices % 3 == 0);
+            std::size_t numTriangles = numIndices / 3;
+            if (!numTriangles) {
+                return;
+            }
+
+            // the triangles using each vertex, those still to be emitted kept at the front of its run
+            std::vector< std::size_t > first(numVertices + 1, 0), remaining(numVertices, 0);
+            for (std::size_t i = 0; i < numIndices; ++i)
+            {
+                assert(indices[i] < numVertices);
+                ++remaining[indices[i]];
+            }
+            for (std::size_t v = 0; v < numVertices; ++v) {
+                first[v + 1] = first[v] + remaining[v];
+            }
+
+            std::vector< std::size_t > triangles(numIndices), fill(first.begin(), first.end() - 1);
+            for (std::size_t i = 0; i < numIndices; ++i) {
+                triangles[fill[indices[i]]++] = i / 3;
+            }
+
+            std::vector< int > cachePosition(numVertices, -1);
+            std::vector< float > vertexScore(numVertices);
+            for (std::size_t v = 0; v < numVertices; ++v) {
+                vertexScore[v] = ScoreVertex(-1, remaining[v]);
+            }
+
+            std::vector< float > triangleScore(numTriangles, 0.0f);
+            std::vector< bool > emitted(numTriangles, false);
+            for (std::size_t i = 0; i < numIndices; ++i) {
+                triangleScore[i / 3] += vertexScore[indices[i]];
+            }
+
+            std::vector< unsigned int > output, cache, updated;
+            output.reserve(numIndices);
+            cache.reserve(CACHE_SIZE + 3);
+            updated.reserve(CACHE_SIZE + 3);
+
+            std::size_t best = NONE, next = 0;
+            for (std::size_t n = 0; n < numTriangles; ++n)
+            {
+                // when none of the cached vertices have triangles left, carry on from the first
+                // triangle not yet emitted rather than searching them all, which keeps it linear
+                if (best == NONE)
+                {
+                    while (emitted[next]) {
+                        ++next;
+                    }
+                    best = next;
+                }
+
+                emitted[best] = true;
+                const unsigned int* corners = indices + best * 3;
+                output.insert(output.end(), corners, corners + 3);
+
+                for (std::size_t k = 0; k < 3; ++k)
+                {
+                    std::size_t v = corners[k];
+                    std::size_t* begin = &triangles[first[v]], *end = begin + remaining[v];
+                    std::iter_swap(std::find(begin, end, best), end - 1);
+                    --remaining[v];
+                }
+
+                // the triangle's vertices go to the front of the cache, pushing the least recently used out
+                updated.assign(corners, corners + 3);
+                for (std::size_t i = 0; i < cache.size(); ++i)
+                {
+                    if (cache[i] != corners[0] && cache[i] != corners[1] && cache[i] != corners[2]) {
+                        updated.push_back(cache[i]);
+                    }
+                }
+
+                // rescore every vertex that moved or fell out, passing the change on to its triangles
+                for (std::size_t i = 0; i < updated.size(); ++i)
+                {
+                    std::size_t v = updated[i];
+                    cachePosition[v] = (i < CACHE_SIZE) ? static_cast<int>(i) : -1;
+
+                    float score = ScoreVertex(cachePosition[v], remaining[v]);
+                    float delta = score - vertexScore[v];
+                    vertexScore[v] = score;
+
+                    for (std::size_t j = first[v]; j < first[v] + remaining[v]; ++j) {
+                        triangleScore[triangles[j]] += delta;
+                    }
+                }
+
+                // then pick the best of the triangles still to go that the cache can help with
+                float bestScore = -1.0f;
+                best = NONE;
+                for (std::size_t i = 0; i < updated.size() && i < CACHE_SIZE; ++i)
+                {
+                    std::size_t v = updated[i];
+                    for (std::size_t j = first[v]; j < first[v] + remaining[v]; ++j)
+                    {
+                        if (triangleScore[triangles[j]] > bestScore)
+                        {
+                            bestScore = triangleScore[triangles[j]];
+                            best = triangles[j];
+                        }
+                    }
+                }
+
+                if (updated.size() > CACHE_SIZE) {
+                    updated.resize(CACHE_SIZE);
+                }
+                cache.swap(updated);
+            }
+
+            std::copy(output.begin(), output.end(), indices);
+        }
+
+        std::size_t OrderVerticesByFirstUse(unsigned int* indices, std::size_t numIndices, std::size_t numVertices,
+            unsigned int* remap)
+        {
+            std::fill(remap, remap + numVertices, NONE);
+
+            unsigned int next = 0;
+            for (std::size_t i = 0; i < numIndices; ++i)
+            {
+                assert(indices[i] < numVertices);
+                if (remap[indices[i]] == NONE) {
+                    remap[indices[i]] = next++;
+                }
+                indices[i] = remap[indices[i]];
+            }
+
+            // any vertices no triangle uses go at the end, in the order they were
+            std::size_t used = next;
+            for (std::size_t v = 0; v < numVertices; ++v)
+            {
+                if (remap[v] == NONE) {
+                    remap[v] = next++;
+                }
+            }
+            return used;
+        }
+
+        float ComputeACMR(const unsigned int* indices, std::size_t numIndices, std::size_t cacheSize)
+        {
+            if (numIndices < 3) {
+                return 0.0f;
+            }
+
+            std::vector< unsigned int > cache(cacheSize, NONE);
+            std::size_t head = 0, misses = 0;
+            for (std::size_t i = 0; i < numIndices; ++i)
+            {
+                if (std::find(cache.begin(), cache.end(), indices[i]) == cache.end())
+                {
+                    cache[head] = indices[i];
+                    head = (head + 1) % cacheSize;
+                    ++misses;
+                }
+            }
+            return static_cast<float>(misses) / (numIndices / 3);
+        }
+    }
+}
@@ -0,0 +1,156 @@
+/*!
+    @file IndexedHeap.h @author Joel Barrett @date 16/10/26 @brief A binary heap whose keys can be changed in place.
+*/
+
+#ifndef FRAMEWORK_UTILITIES_INDEXEDHEAP_H
+#define FRAMEWORK_UTILITIES_INDEXEDHEAP_H
+
+#if _MSC_VER > 1000
+    #pragma once
+#endif
+
+#include <cassert>
+#include <vector>
+#include <functional>
+
+namespace Framework
+{
+    namespace Utilities
+    {
+        /*!
+            A binary heap over items identified by small integer ids, keeping the
+            position of every id in the heap so that its key can be changed in
+            O(log n) without searching for it. With the default comparison the
+            item with the greatest key is on top. Member names follow the std
+            containers.
+        */
+        template < typename Key, typename Compare = std::less<Key> >
+        class IndexedHeap
+        {
+        public:
+            explicit IndexedHeap(const Compare &compare = Compare()): compare_(compare){}
+
+            std::size_t size() const { return heap_.size(); }
+            bool empty() const { return heap_.empty(); }
+            void clear() { heap_.clear(); keys_.clear(); positions_.clear(); }
+
+            bool contains(std::size_t id) const { return id < positions_.size() && positions_[id] != NPOS; }
+
+            //! the id and key of the item on top
+            std::size_t top() const { assert(!empty()); return heap_[0]; }
+            const Key& top_key() const { assert(!empty()); return keys_[heap_[0]]; }
+            const Key& key(std::size_t id) const { assert(contains(id)); return keys_[id]; }
+
+            //! add item id, which must not already be in the heap
+            void push(std::size_t id, const Key &key);
+
+            //! change the key of item id, moving it up or down as needed
+            void update(std::size_t id, const Key &key);
+
+            //! remove the item on top
+            void pop();
+
+        private:
+            void SiftUp(std::size_t i);
+            void SiftDown(std::size_t i);
+            void Place(std::size_t i, std::size_t id) { heap_[i] = id; positions_[id] = i; }
+
+        private:
+            static const std::size_t NPOS = ~std::size_t(0);
+
+            std::vector<std::size_t> heap_; //!< ids in heap order
+            std::vector<Key> keys_; //!< indexed by id
+            std::vector<std::size_t> positions_; //!< index into heap_ of each id, or NPOS
+
+            Compare compare_;
+        };
+
+        template < typename Key, typename Compare >
+        inline void IndexedHeap<Key,Compare>::push(std::size_t id, const Key &key)
+        {
+            if (id >= positions_.size())
+            {
+                positions_.resize(id + 1, std::size_t(NPOS));
+                keys_.resize(id + 1);
+            }
+            assert(positions_[id] == NPOS);
+
+            keys_[id] = key;
+            heap_.push_back(id);
+            positions_[id] = heap_.size() - 1;
+            SiftUp(heap_.size() - 1);
+        }
+
+        template < typename Key, typename Compare >
+        inline void IndexedHeap<Key,Compare>::update(std::size_t id, const Key &key)
+        {
+            assert(contains(id));
+
+            bool up = compare_(keys_[id], key);
+            keys_[id] = key;
+
+            if (up) {
+                SiftUp(positions_[id]);
+            }
+            else {
+                SiftDown(positions_[id]);
+            }
+        }
+
+        template < typename Key, typename Compare >
+        inline void IndexedHeap<Key,Compare>::pop()
+        {
+            assert(!empty());
+
+            positions_[heap_[0]] = NPOS;
+            std::size_t last = heap_.back();
+            heap_.pop_back();
+
+            if (!heap_.empty())
+            {
+                Place(0, last);
+                SiftDown(0);
+            }
+        }
+
+        template < typename Key, typename Compare >
+        inline void IndexedHeap<Key,Compare>::SiftUp(std::size_t i)
+        {
+            std::size_t id = heap_[i];
+            while (i > 0)
+            {
+                std::size_t parent = (i - 1) / 2;
+                if (!compare_(keys_[heap_[parent]], keys_[id])) {
+                    break;
+                }
+                Place(i, heap_[parent]);
+                i = parent;
+            }
+            Place(i, id);
+        }
+
+        template < typename Key, typename Compare >
+        inline void IndexedHeap<Key,Compare>::SiftDown(std::size_t i)
+        {
+            std::size_t id = heap_[i];
+            for (;;)
+            {
+                std::size_t child = 2 * i + 1;
+                if (child >= heap_.size()) {
+                    break;
+                }
+                if (child + 1 < heap_.size() && compare_(keys_[heap_[child]], keys_[heap_[child + 1]])) {
+                    ++child;
+                }
+                if (!compare_(keys_[id], keys_[heap_[child]])) {
+                    break;
+                }
+                Place(i, heap_[child]);
+                i = child;
+            }
+            Place(i, id);
+        }
+    }
+}
+
+#endif // FRAMEWORK_UTILITIES_INDEXEDHEAP_H
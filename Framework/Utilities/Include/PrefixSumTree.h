@@ -0,0 +1,240 @@
+/*!
+    @file PrefixSumTree.h @author Joel Barrett @date 16/10/26 @brief Running totals over a sequence that can grow in the middle.
+*/
+
+#ifndef FRAMEWORK_UTILITIES_PREFIXSUMTREE_H
+#define FRAMEWORK_UTILITIES_PREFIXSUMTREE_H
+
+#if _MSC_VER > 1000
+    #pragma once
+#endif
+
+#include <cassert>
+#include <vector>
+
+namespace Framework
+{
+    namespace Utilities
+    {
+        /*!
+            A sequence of values, each identified by a small integer id, with the sum
+            of the values before any item and the item containing any running total
+            found in O(log n). Unlike a Fenwick tree over an array, items can be
+            inserted anywhere in the sequence without renumbering the ones after
+            them: the items are held in a treap ordered by their position, whose
+            priorities are hashed from the ids so the shape is reproducible. Each
+            node keeps the sum of its subtree, so changing a value only touches the
+            path to the root. Member names follow the std containers.
+        */
+        template < typename T >
+        class PrefixSumTree
+        {
+        public:
+            //! an id which refers to no item, inserting at the end when passed as before
+            static const std::size_t NPOS = ~std::size_t(0);
+
+        public:
+            PrefixSumTree(): root_(NPOS), size_(0){}
+
+            std::size_t size() const { return size_; }
+            bool empty() const { return root_ == NPOS; }
+            void clear() { nodes_.clear(); root_ = NPOS; size_ = 0; }
+
+            //! sum of every value
+            T total() const { return Sum(root_); }
+            const T& value(std::size_t id) const { assert(id < nodes_.size()); return nodes_[id].value; }
+
+            //! add item id, which must not already be in the tree, in front of item before
+            void insert(std::size_t id, const T &value, std::size_t before = NPOS);
+
+            //! change the value of item id
+            void update(std::size_t id, const T &value);
+
+            //! sum of the values of the items in front of item id
+            T prefix(std::size_t id) const;
+
+            /*!
+                The item whose span of running totals contains sum, which is clamped
+                to [0, total()], and how far into its span sum falls.
+            */
+            std::size_t find(T sum, T &offset) const;
+
+        private:
+            struct Node
+            {
+                Node(): left(NPOS), right(NPOS), parent(NPOS), priority(0), value(0), sum(0){}
+
+                std::size_t left, right, parent;
+                unsigned int priority;
+                T value, sum;
+            };
+
+            T Sum(std::size_t n) const { return n == NPOS ? T(0) : nodes_[n].sum; }
+            void Pull(std::size_t n) { nodes_[n].sum = Sum(nodes_[n].left) + nodes_[n].value + Sum(nodes_[n].right); }
+
+            //! rotate n above its parent
+            void Rotate(std::size_t n);
+
+            std::size_t Last(std::size_t n) const;
+
+            //! scatter the bits of an id, a 32-bit finalizer from MurmurHash3
+            static unsigned int Hash(std::size_t id);
+
+        private:
+            std::vector<Node> nodes_; //!< indexed by id
+            std::size_t root_, size_;
+        };
+
+        template < typename T >
+        inline void PrefixSumTree<T>::insert(std::size_t id, const T &value, std::size_t before)
+        {
+            if (id >= nodes_.size()) {
+                nodes_.resize(id + 1);
+            }
+            nodes_[id] = Node();
+            nodes_[id].priority = Hash(id);
+            nodes_[id].value = nodes_[id].sum = value;
+            ++size_;
+
+            // attach the item as a leaf immediately in front of before, then rotate it up into heap order
+            std::size_t parent = NPOS;
+            if (root_ == NPOS) {
+                root_ = id;
+            }
+            else if (before == NPOS) {
+                parent = Last(root_);
+                nodes_[parent].right = id;
+            }
+            else if (nodes_[before].left == NPOS) {
+                parent = before;
+                nodes_[parent].left = id;
+            }
+            else {
+                parent = Last(nodes_[before].left);
+                nodes_[parent].right = id;
+            }
+            nodes_[id].parent = parent;
+
+            for (std::size_t n = parent; n != NPOS; n = nodes_[n].parent) {
+                nodes_[n].sum += value;
+            }
+            while (nodes_[id].parent != NPOS && nodes_[id].priority > nodes_[nodes_[id].parent].priority) {
+                Rotate(id);
+            }
+        }
+
+        template < typename T >
+        inline void PrefixSumTree<T>::update(std::size_t id, const T &value)
+        {
+            assert(id < nodes_.size());
+
+            nodes_[id].value = value;
+            for (std::size_t n = id; n != NPOS; n = nodes_[n].parent) {
+                Pull(n);
+            }
+        }
+
+        template < typename T >
+        inline T PrefixSumTree<T>::prefix(std::size_t id) const
+        {
+            assert(id < nodes_.size());
+
+            T sum = Sum(nodes_[id].left);
+            for (std::size_t n = id; nodes_[n].parent != NPOS; n = nodes_[n].parent)
+            {
+                const Node &parent = nodes_[nodes_[n].parent];
+                if (parent.right == n) {
+                    sum += Sum(parent.left) + parent.value;
+                }
+            }
+            return sum;
+        }
+
+        template < typename T >
+        inline std::size_t PrefixSumTree<T>::find(T sum, T &offset) const
+        {
+            assert(!empty());
+
+            std::size_t n = root_;
+            for (;;)
+            {
+                const Node &node = nodes_[n];
+                if (node.left != NPOS && sum < Sum(node.left)) {
+                    n = node.left;
+                    continue;
+                }
+                sum -= Sum(node.left);
+
+                if (node.right == NPOS || sum < node.value) {
+                    break;
+                }
+                sum -= node.value;
+                n = node.right;
+            }
+
+            // rounding can leave the running total fractionally outside the item it landed on
+            offset = sum < T(0) ? T(0) : (sum > nodes_[n].value ? nodes_[n].value : sum);
+            return n;
+        }
+
+        template < typename T >
+        inline void PrefixSumTree<T>::Rotate(std::size_t n)
+        {
+            std::size_t parent = nodes_[n].parent;
+            std::size_t grandparent = nodes_[parent].parent;
+
+            if (nodes_[parent].left == n)
+            {
+                nodes_[parent].left = nodes_[n].right;
+                if (nodes_[n].right != NPOS) {
+                    nodes_[nodes_[n].right].parent = parent;
+                }
+                nodes_[n].right = parent;
+            }
+            else
+            {
+                nodes_[parent].right = nodes_[n].left;
+                if (nodes_[n].left != NPOS) {
+                    nodes_[nodes_[n].left].parent = parent;
+                }
+                nodes_[n].left = parent;
+            }
+            nodes_[parent].parent = n;
+            nodes_[n].parent = grandparent;
+
+            if (grandparent == NPOS) {
+                root_ = n;
+            }
+            else if (nodes_[grandparent].left == parent) {
+                nodes_[grandparent].left = n;
+            }
+            else {
+                nodes_[grandparent].right = n;
+            }
+
+            Pull(parent);
+            Pull(n);
+        }
+
+        template < typename T >
+        inline std::size_t PrefixSumTree<T>::Last(std::size_t n) const
+        {
+            while (nodes_[n].right != NPOS) {
+                n = nodes_[n].right;
+            }
+            return n;
+        }
+
+        template < typename T >
+        inline unsigned int PrefixSumTree<T>::Hash(std::size_t id)
+        {
+            unsigned int h = static_cast<unsigned int>(id);
+            h ^= h >> 16; h *= 0x85ebca6bu;
+            h ^= h >> 13; h *= 0xc2b2ae35u;
+            h ^= h >> 16;
+            return h;
+        }
+    }
+}
+
+#endif // FRAMEWORK_UTILITIES_PREFIXSUMTREE_H
@@ -0,0 +1,242 @@
+/*!
+    @file ThreadPool.h @author Joel Barrett @date 16/10/26 @brief A pool of worker threads.
+*/
+
+#ifndef FRAMEWORK_UTILITIES_THREADPOOL_H
+#define FRAMEWORK_UTILITIES_THREADPOOL_H
+
+#if _MSC_VER > 1000
+    #pragma once
+#endif
+
+#include <cassert>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+
+namespace Framework
+{
+    namespace Utilities
+    {
+        /*!
+            A fixed set of worker threads that split loops over an index range. The 
+            calling thread works alongside the pool, so a pool of one thread runs 
+            everything inline. ParallelFor should only be called from one thread at 
+            a time.
+            
+            Each thread starts on an equal, contiguous share of the range and takes 
+            chunks of grain indices from its front. A thread that runs out steals 
+            the back half of another thread's remaining share, so a share of 
+            expensive indices is spread over the pool rather than holding it up. 
+            Which thread runs an index varies from run to run, so tasks must write 
+            only to the indices they are given for their results to be reproducible.
+        */
+        class ThreadPool
+        {
+        public:
+            //! task over the half-open index range [begin, end)
+            typedef std::function<void (std::size_t, std::size_t)> Task;
+            
+        public:
+            //! threads includes the caller; 0 means one per hardware thread
+            explicit ThreadPool(std::size_t threads = 0);
+            ~ThreadPool();
+            
+            std::size_t GetNumThreads() const { return workers_.size() + 1; }
+            
+            //! run task over [0, count) in chunks of grain indices, returning once all are done
+            void ParallelFor(std::size_t count, std::size_t grain, const Task &task);
+            
+        private:
+            ThreadPool(const ThreadPool &);
+            ThreadPool& operator = (const ThreadPool &);
+            
+            void WorkerLoop(std::size_t self);
+            void RunChunks(std::size_t self);
+            
+            //! take up to grain indices from the front of share, returning false once it is empty
+            bool Take(std::size_t share, std::size_t &begin, std::size_t &end);
+            
+            //! move the back half of another thread's share into share self
+            bool Steal(std::size_t self);
+            
+            // a share of the range packed as begin in the low and end in the high 32 bits
+            static unsigned long long Pack(std::size_t begin, std::size_t end) { return begin | (static_cast<unsigned long long>(end) << 32); }
+            static std::size_t Begin(unsigned long long share) { return static_cast<std::size_t>(share & 0xffffffffu); }
+            static std::size_t End(unsigned long long share) { return static_cast<std::size_t>(share >> 32); }
+            
+            //! padded to a cache line so that threads taking from their own shares don't contend
+            struct Share
+            {
+                Share(): range(0){}
+                
+                std::atomic<unsigned long long> range;
+                char padding[64 - sizeof(std::atomic<unsigned long long>)];
+            };
+            
+        private:
+            std::vector<std::thread> workers_;
+            std::vector<Share> shares_; //!< one per thread, the caller's first
+            
+            std::mutex mutex_;
+            std::condition_variable wake_, done_;
+            
+            // the current loop
+            const Task* task_;
+            std::size_t grain_;
+            
+            std::size_t busy_; //!< workers yet to finish the current loop
+            unsigned generation_; //!< incremented for every loop
+            bool quit_;
+        };
+        
+        inline ThreadPool::ThreadPool(std::size_t threads)
+            : task_(NULL), grain_(1), busy_(0), generation_(0), quit_(false)
+        {
+            if (!threads) {
+                threads = std::thread::hardware_concurrency();
+            }
+            if (!threads) {
+                threads = 1;
+            }
+            shares_ = std::vector<Share>(threads);
+            
+            for (std::size_t i = 1; i < threads; ++i) {
+                workers_.push_back(std::thread(&ThreadPool::WorkerLoop, this, i));
+            }
+        }
+        
+        inline ThreadPool::~ThreadPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                quit_ = true;
+            }
+            wake_.notify_all();
+            
+            for (std::size_t i = 0; i < workers_.size(); ++i) {
+                workers_[i].join();
+            }
+        }
+        
+        inline void ThreadPool::ParallelFor(std::size_t count, std::size_t grain, const Task &task)
+        {
+            if (!grain) {
+                grain = 1;
+            }
+            // not worth waking anyone for a single chunk
+            if (workers_.empty() || count <= grain)
+            {
+                if (count) {
+                    task(0, count);
+                }
+                return;
+            }
+            assert(count <= 0xffffffffu);
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                task_ = &task;
+                grain_ = grain;
+                busy_ = workers_.size();
+                ++generation_;
+                
+                for (std::size_t i = 0; i < shares_.size(); ++i) {
+                    shares_[i].range = Pack(count * i / shares_.size(), count * (i + 1) / shares_.size());
+                }
+            }
+            wake_.notify_all();
+            RunChunks(0);
+            
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (busy_) {
+                done_.wait(lock);
+            }
+            task_ = NULL;
+        }
+        
+        inline void ThreadPool::WorkerLoop(std::size_t self)
+        {
+            unsigned seen = 0;
+            for (;;)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    while (!quit_ && generation_ == seen) {
+                        wake_.wait(lock);
+                    }
+                    if (quit_) {
+                        return;
+                    }
+                    seen = generation_;
+                }
+                RunChunks(self);
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    --busy_;
+                }
+                done_.notify_one();
+            }
+        }
+        
+        inline void ThreadPool::RunChunks(std::size_t self)
+        {
+            std::size_t begin, end;
+            do
+            {
+                while (Take(self, begin, end)) {
+                    (*task_)(begin, end);
+                }
+            } while (Steal(self));
+        }
+        
+        inline bool ThreadPool::Take(std::size_t share, std::size_t &begin, std::size_t &end)
+        {
+            unsigned long long range = shares_[share].range.load();
+            for (;;)
+            {
+                begin = Begin(range);
+                end = End(range);
+                if (begin >= end) {
+                    return false;
+                }
+                std::size_t next = end - begin > grain_ ? begin + grain_ : end;
+                if (shares_[share].range.compare_exchange_weak(range, Pack(next, end)))
+                {
+                    end = next;
+                    return true;
+                }
+            }
+        }
+        
+        inline bool ThreadPool::Steal(std::size_t self)
+        {
+            // visit the other shares in turn, starting with the next thread's
+            for (std::size_t i = 1; i < shares_.size(); ++i)
+            {
+                std::size_t victim = (self + i) % shares_.size();
+                unsigned long long range = shares_[victim].range.load();
+                
+                for (;;)
+                {
+                    std::size_t begin = Begin(range), end = End(range);
+                    if (begin >= end) {
+                        break;
+                    }
+                    // half of what is left, or all of it if that is no more than a chunk
+                    std::size_t mid = end - begin > grain_ ? begin + (end - begin) / 2 : begin;
+                    if (shares_[victim].range.compare_exchange_weak(range, Pack(begin, mid)))
+                    {
+                        shares_[self].range = Pack(mid, end);
+                        return true;
+                    }
+                }
+            }
+            return false;
+        }
+    }
+}
+
+#endif // FRAMEWORK_UTILITIES_THREADPOOL_H
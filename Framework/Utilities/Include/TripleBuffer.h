@@ -0,0 +1,66 @@
+/*!
+    @file TripleBuffer.h @author Joel Barrett @date 16/10/26 @brief Lock-free hand-over of state from one thread to another.
+*/
+
+#ifndef FRAMEWORK_UTILITIES_TRIPLEBUFFER_H
+#define FRAMEWORK_UTILITIES_TRIPLEBUFFER_H
+
+#if _MSC_VER > 1000
+    #pragma once
+#endif
+
+#include <atomic>
+
+namespace Framework
+{
+    namespace Utilities
+    {
+        /*!
+            Three copies of T shared by one writing and one reading thread. The
+            writer fills the back buffer and publishes it by swapping it with the
+            middle one; the reader takes the middle buffer in exchange for its
+            front one whenever something new has been published. Neither side ever
+            waits for the other, and the reader always sees a complete buffer,
+            though it skips any the writer publishes faster than they are read.
+        */
+        template < typename T >
+        class TripleBuffer
+        {
+        public:
+            TripleBuffer(): front_(0), middle_(1), back_(2){}
+
+            //! the buffer the writer fills
+            T& Back() { return buffers_[back_]; }
+
+            //! hand the back buffer to the reader
+            void Publish() { back_ = middle_.exchange(back_ | FRESH) & INDEX; }
+
+            //! take the most recently published buffer, if there is one the reader hasn't seen
+            bool Acquire()
+            {
+                if (!(middle_.load() & FRESH)) {
+                    return false;
+                }
+                front_ = middle_.exchange(front_) & INDEX;
+                return true;
+            }
+
+            //! the buffer the reader last acquired
+            const T& Front() const { return buffers_[front_]; }
+
+        private:
+            TripleBuffer(const TripleBuffer &);
+            TripleBuffer& operator = (const TripleBuffer &);
+
+            // the middle index is flagged while it holds a buffer the reader hasn't taken
+            enum { INDEX = 3, FRESH = 4 };
+
+            T buffers_[3];
+            unsigned front_; //!< owned by the reader
+            std::atomic<unsigned> middle_;
+            unsigned back_; //!< owned by the writer
+        };
+    }
+}
+
+#endif // FRAMEWORK_UTILITIES_TRIPLEBUFFER_H